@@ -2,21 +2,55 @@
 #define __NVM_TREE_BENCH_HPP__
 
 #include "cpucounters.h"
+#include "cpu_topology.hpp"
+#include "histogram.hpp"
 #include "key_generator.hpp"
+#include "latency_timer.hpp"
 #include "operation_generator.hpp"
 #include "stopwatch.hpp"
 #include "tree_api.hpp"
 #include "value_generator.hpp"
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory> // For unique_ptr
 #include <chrono> // std::chrono::high_resolution_clock::time_point
+#include <string>
 #include <vector>
 
 namespace PiBench
 {
 
-void print_environment();
+/**
+ * @brief Description of the machine running the benchmark.
+ *
+ */
+struct environment_t
+{
+    /// Local time the benchmark started.
+    std::string time;
+
+    /// Number of logical CPUs.
+    uint64_t num_cpus = 0;
+
+    /// CPU model name.
+    std::string cpu_type;
+
+    /// Size of the CPU cache as reported by /proc/cpuinfo.
+    std::string cache_size;
+
+    /// Operating system and kernel release.
+    std::string kernel;
+};
+
+/// Collect description of the machine running the benchmark.
+environment_t get_environment();
+
+/// Resident set size of this process in Bytes (0 if unknown).
+uint64_t resident_memory();
+
+void print_environment(const environment_t& env);
 
 /**
  * @brief Benchmark mode
@@ -35,9 +69,138 @@ enum class distribution_t : uint8_t
 {
     UNIFORM = 0,
     SELFSIMILAR = 1,
-    ZIPFIAN = 2
+    ZIPFIAN = 2,
+
+    /// Zipfian over the most recently inserted records (YCSB's latest).
+    LATEST = 3,
+
+    /// Zipfian with the hottest records spread over the keyspace (YCSB's
+    /// scrambled zipfian), independent of the order they were loaded in.
+    SCRAMBLED_ZIPFIAN = 4,
+
+    /// Zipfian with the hottest records next to each other in key order.
+    CLUSTERED_ZIPFIAN = 5,
+
+    /// A fraction of the operations on a hot set of the records (YCSB's
+    /// hotspot), the rest uniform over the other records.
+    HOTSPOT = 6
+};
+
+/**
+ * @brief How the hot set of the HOTSPOT distribution moves during a run.
+ *
+ */
+enum class hot_shift_t : uint8_t
+{
+    /// The hot set stays at the first records.
+    NONE = 0,
+
+    /// The hot set advances over the keyspace by a fixed step.
+    SLIDE = 1,
+
+    /// The hot set moves to a random position of the keyspace.
+    JUMP = 2
+};
+
+/**
+ * @brief Inter-arrival time of requests in open-loop mode.
+ *
+ */
+enum class arrival_t : uint8_t
+{
+    CONSTANT = 0,
+    POISSON = 1
+};
+
+/**
+ * @brief Distribution of the number of records read by scans.
+ *
+ */
+enum class scan_length_t : uint8_t
+{
+    /// Every scan reads 'scan_size' records.
+    CONSTANT = 0,
+
+    /// Scans read between 1 and 'scan_size' records, uniformly.
+    UNIFORM = 1
 };
 
+/**
+ * @brief How records are loaded into the tree.
+ *
+ */
+enum class load_mode_t : uint8_t
+{
+    /// One insert per record, in the order keys are generated.
+    INSERT = 0,
+
+    /// Records are generated and sorted first, then handed to bulk_load().
+    BULK = 1
+};
+
+/**
+ * @brief Parse name of a key distribution (case insensitive).
+ *
+ * @param name
+ * @param[out] dist
+ * @return true if name is a valid distribution.
+ */
+bool parse_distribution(std::string name, distribution_t& dist);
+
+/**
+ * @brief Parse name of a hot set shift (case insensitive).
+ *
+ * @param name
+ * @param[out] shift
+ * @return true if name is a valid hot set shift.
+ */
+bool parse_hot_shift(std::string name, hot_shift_t& shift);
+
+/**
+ * @brief Parse name of an arrival distribution (case insensitive).
+ *
+ * @param name
+ * @param[out] arrival
+ * @return true if name is a valid arrival distribution.
+ */
+bool parse_arrival(std::string name, arrival_t& arrival);
+
+/**
+ * @brief Parse name of a key order (case insensitive).
+ *
+ * @param name
+ * @param[out] order
+ * @return true if name is a valid key order.
+ */
+bool parse_key_order(std::string name, key_order_t& order);
+
+/**
+ * @brief Parse name of a key encoding (case insensitive).
+ *
+ * @param name
+ * @param[out] encoding
+ * @return true if name is a valid key encoding.
+ */
+bool parse_key_encoding(std::string name, key_encoding_t& encoding);
+
+/**
+ * @brief Parse name of a load mode (case insensitive).
+ *
+ * @param name
+ * @param[out] mode
+ * @return true if name is a valid load mode.
+ */
+bool parse_load_mode(std::string name, load_mode_t& mode);
+
+/**
+ * @brief Parse name of a scan length distribution (case insensitive).
+ *
+ * @param name
+ * @param[out] length
+ * @return true if name is a valid scan length distribution.
+ */
+bool parse_scan_length(std::string name, scan_length_t& length);
+
 /**
  * @brief Benchmark options.
  *
@@ -56,8 +219,8 @@ struct options_t
     /// Number of parallel threads used for executing requests.
     uint32_t num_threads = 1;
 
-    /// Sampling window in milliseconds.
-    uint32_t sampling_ms = 1000;
+    /// Sampling window in milliseconds (fractions allowed).
+    double sampling_ms = 1000;
 
     /// Key prefix.
     std::string key_prefix = "";
@@ -65,6 +228,15 @@ struct options_t
     /// Size of key in bytes.
     uint32_t key_size = 8;
 
+    /// How record ids are mapped to keys (i.e., the order of inserts).
+    key_order_t key_order = key_order_t::HASHED;
+
+    /// Maximum displacement of keys in KSORTED order.
+    uint64_t key_displacement = 64;
+
+    /// Byte order of ids in keys.
+    key_encoding_t key_encoding = key_encoding_t::NATIVE;
+
     /// Size of value in bytes.
     uint32_t value_size = 8;
 
@@ -83,15 +255,37 @@ struct options_t
     /// Ratio of scan operations.
     float scan_ratio = 0.0;
 
-    /// Size of scan operations in records.
+    /// Ratio of read-modify-write operations.
+    float rmw_ratio = 0.0;
+
+    /// Size of scan operations in records (maximum size if not constant).
     uint32_t scan_size = 100;
 
+    /// Distribution of the size of scan operations.
+    scan_length_t scan_length = scan_length_t::CONSTANT;
+
     /// Distribution used for generation random keys.
     distribution_t key_distribution = distribution_t::UNIFORM;
 
     /// Factor to be used for skewed random key distributions.
     float key_skew = 0.2;
 
+    /// Fraction of the keyspace in the hot set (HOTSPOT distribution).
+    double hot_set = 0.2;
+
+    /// Fraction of the operations on the hot set (HOTSPOT distribution).
+    double hot_ops = 0.8;
+
+    /// How the hot set moves during the run.
+    hot_shift_t hot_shift = hot_shift_t::NONE;
+
+    /// Interval between moves of the hot set in milliseconds, rounded to
+    /// whole sampling windows.
+    double hot_shift_ms = 1000;
+
+    /// Fraction of the keyspace the hot set advances by when sliding.
+    double hot_step = 0.01;
+
     /// Master seed to be used for random generations.
     uint32_t rnd_seed = 1729;
 
@@ -101,72 +295,551 @@ struct options_t
     /// Whether to skip the load phase.
     bool skip_load = false;
 
+    /// How records are loaded into the tree.
+    load_mode_t load_mode = load_mode_t::INSERT;
+
+    /// Records per call to bulk_load() (0 for all records at once).
+    uint64_t load_chunk = 0;
+
+    /// Whether to look up every record after loading.
+    bool load_verify = true;
+
     /// Ratio of requests to sample latency from (between 0.0 and 1.0).
     float latency_sampling = 0.0;
 
+    /// Clock source used to measure latency.
+    timer_source_t latency_timer = timer_source_t::CHRONO;
+
+    /// Whether to subtract the timer overhead from measured latencies.
+    bool subtract_timer_overhead = false;
+
     /// Experiment duration (seconds) for time-based benchmark
     uint32_t seconds = 20;
 
     /// Experiment mode
     mode_t bm_mode = mode_t::Operation;
+
+    /// Target aggregate rate of requests (ops/s) in open-loop mode; 0 runs closed-loop.
+    double rate = 0.0;
+
+    /// Distribution of inter-arrival times in open-loop mode.
+    arrival_t arrival = arrival_t::CONSTANT;
+
+    /// Whether to generate all requests before the run (operation mode only).
+    bool pregenerate = false;
+
+    /// Trace file to record the requests of the run to (operation mode only).
+    std::string record_trace = "";
+
+    /// Trace file to replay requests from instead of generating them.
+    std::string replay_trace = "";
+
+    /// Number of reads and inserts issued to the tree at once (1 disables batching).
+    uint32_t batch_size = 1;
+
+    /// Number of lookups each thread keeps in flight (1 disables interleaving).
+    uint32_t interleave = 1;
+
+    /// Policy used to pin worker threads to CPUs.
+    affinity_t affinity = affinity_t::NONE;
+
+    /// CPUs used by the LIST affinity policy, in thread order.
+    std::vector<uint32_t> cpus;
+
+    /// Memory policy of the threads loading the tree.
+    mempolicy_t load_mempolicy = mempolicy_t::DEFAULT;
+
+    /// Memory policy of the threads running the workload.
+    mempolicy_t run_mempolicy = mempolicy_t::DEFAULT;
+
+    /// Nodes used by the INTERLEAVE and BIND memory policies (empty for all).
+    std::vector<uint32_t> mempolicy_nodes;
 };
 
 /**
- * @brief Statistics collected over time.
+ * @brief Set up options as one of the YCSB core workloads.
+ *
+ * Sets the operation mix, the request and scan length distributions and the
+ * value size (10 fields of 100 Bytes) as defined by the YCSB workloads A to F.
+ * Other options, such as the number of records and operations, are kept.
+ *
+ * @param name one of "ycsb-a" to "ycsb-f" (case insensitive).
+ * @param opt options to be changed.
+ * @return true if name is a valid workload.
+ */
+bool apply_workload_preset(std::string name, options_t& opt);
+
+/**
+ * @brief Snapshot of operation counters.
  *
  */
-struct alignas(64) stats_t
+struct stats_t
 {
     stats_t()
         : operation_count(0)
-        , insert_count(0)
-        , success_insert_count(0)
-        , read_count(0)
-        , success_read_count(0)
-        , update_count(0)
-        , success_update_count(0)
-        , remove_count(0)
-        , success_remove_count(0)
-        , scan_count(0)
-        , success_scan_count(0)
+        , completed{}
+        , succeeded{}
     {
     }
 
     /// Number of operations completed.
     uint64_t operation_count;
 
-    /// Number of inserts completed
-    uint64_t insert_count;
+    /// Number of operations completed, indexed by operation_t.
+    uint64_t completed[NUM_OPERATIONS];
+
+    /// Number of operations that succeeded, indexed by operation_t.
+    uint64_t succeeded[NUM_OPERATIONS];
+
+    stats_t& operator+=(const stats_t& other) noexcept
+    {
+        operation_count += other.operation_count;
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            completed[op] += other.completed[op];
+            succeeded[op] += other.succeeded[op];
+        }
+        return *this;
+    }
+
+    stats_t& operator-=(const stats_t& other) noexcept
+    {
+        operation_count -= other.operation_count;
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            completed[op] -= other.completed[op];
+            succeeded[op] -= other.succeeded[op];
+        }
+        return *this;
+    }
+
+    /// Total number of operations that succeeded.
+    uint64_t succeeded_count() const noexcept
+    {
+        uint64_t sum = 0;
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            sum += succeeded[op];
+        return sum;
+    }
+};
 
-    /// Number of successful inserts
-    uint64_t success_insert_count;
+/**
+ * @brief Operation counters of a single worker thread.
+ *
+ * Counters are only written by the owner thread, so an increment is a plain
+ * relaxed load and store (no locked instruction). Updates are published
+ * under a sequence lock: the monitor thread can take a consistent snapshot
+ * of all counters at any time without ever blocking the worker, which keeps
+ * short sampling windows cheap. Each instance sits on its own cache lines.
+ */
+class alignas(64) thread_stats_t
+{
+public:
+    /**
+     * @brief Account for a completed operation.
+     *
+     * Must only be called by the owner thread.
+     *
+     * @param op type of the operation.
+     * @param succeeded whether the operation succeeded.
+     */
+    void record(operation_t op, bool succeeded) noexcept
+    {
+        auto i = static_cast<size_t>(op);
+        auto seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-    /// Number of reads completed
-    uint64_t read_count;
+        increment(operation_count_);
+        increment(completed_[i]);
+        if (succeeded)
+            increment(succeeded_[i]);
 
-    /// Number of successful point reads
-    uint64_t success_read_count;
+        seq_.store(seq + 2, std::memory_order_release);
+    }
 
-    /// Number of updates completed
-    uint64_t update_count;
+    /// Number of operations of the given type completed so far.
+    uint64_t completed(operation_t op) const noexcept
+    {
+        return completed_[static_cast<size_t>(op)].load(std::memory_order_relaxed);
+    }
 
-    /// Number of successful point reads
-    uint64_t success_update_count;
+    /**
+     * @brief Read all counters consistently.
+     *
+     * Retries while the owner thread is in the middle of an update.
+     *
+     * @return stats_t
+     */
+    stats_t snapshot() const noexcept
+    {
+        stats_t s;
+        uint64_t before, after;
+        do
+        {
+            before = seq_.load(std::memory_order_acquire);
+            s.operation_count = operation_count_.load(std::memory_order_relaxed);
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            {
+                s.completed[op] = completed_[op].load(std::memory_order_relaxed);
+                s.succeeded[op] = succeeded_[op].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        }
+        while (before != after || (before & 1));
+        return s;
+    }
 
-    /// Number of remove completed
-    uint64_t remove_count;
+private:
+    static void increment(std::atomic<uint64_t>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
 
-    /// Number of successful point reads
-    uint64_t success_remove_count;
+    /// Sequence number, odd while an update is in progress.
+    std::atomic<uint64_t> seq_{0};
 
-    /// Number of scan completed
-    uint64_t scan_count;
+    /// Number of operations completed.
+    std::atomic<uint64_t> operation_count_{0};
 
-    /// Number of successful point reads
-    uint64_t success_scan_count;
+    /// Number of operations completed, indexed by operation_t.
+    std::atomic<uint64_t> completed_[NUM_OPERATIONS] = {};
 
-    /// Vector to store both start and end time of requests.
-    std::vector<std::chrono::high_resolution_clock::time_point> times;
+    /// Number of operations that succeeded, indexed by operation_t.
+    std::atomic<uint64_t> succeeded_[NUM_OPERATIONS] = {};
+};
+
+/**
+ * @brief Newest id such that every id up to it was inserted by some thread.
+ *
+ * Thread t inserts its k-th record (counting from 0) with id
+ * first_insert_id + t + k * stats.size(), so the ids inserted so far are
+ * dense up to the slowest thread, plus the leading threads that are ahead
+ * of it.
+ *
+ * @param first_insert_id first id inserted by the run.
+ * @param stats counters of each thread.
+ * @return uint64_t first_insert_id - 1 if nothing is known to be inserted.
+ */
+uint64_t insert_frontier(uint64_t first_insert_id, const std::vector<thread_stats_t>& stats) noexcept;
+
+/**
+ * @brief Random streams of a thread.
+ *
+ */
+enum class random_stream_t : uint8_t
+{
+    /// Keys of requests.
+    KEY = 0,
+
+    /// Lengths of scans.
+    SCAN = 1,
+
+    /// Inter-arrival times in open-loop mode.
+    ARRIVAL = 2,
+
+    /// Random moves of the hot set, drawn by the monitor thread (tid 0).
+    HOT_SET = 3
+};
+
+/**
+ * @brief Seed of a random stream of a thread.
+ *
+ * Keys keep the seed rnd_seed * (tid + 1), so a given seed draws the same
+ * keys as before. The other streams hash the seed, the thread and the stream
+ * with splitmix64, so their engines never run in lockstep with the key
+ * engine or with each other.
+ *
+ * @param rnd_seed master seed.
+ * @param tid worker thread.
+ * @param stream
+ * @return uint64_t
+ */
+uint64_t stream_seed(uint32_t rnd_seed, uint32_t tid, random_stream_t stream) noexcept;
+
+/**
+ * @brief Id of the record at a recency rank of the LATEST distribution.
+ *
+ * Rank 1 is the newest record. Ranks older than the oldest record wrap
+ * around to the newest ones, so ids stay in [1, newest].
+ *
+ * @param rank recency rank, from 1.
+ * @param newest newest id (0 if unknown, then the rank is used as the id).
+ * @return uint64_t
+ */
+uint64_t latest_id(uint64_t rank, uint64_t newest) noexcept;
+
+/**
+ * @brief Latency histograms of a single thread.
+ *
+ * Histograms are kept separately per operation type and per outcome, so
+ * that the tail of one kind of request (e.g., scans or negative lookups)
+ * does not hide behind the others.
+ */
+struct latency_stats_t
+{
+    /// Latencies indexed by [operation_t][succeeded].
+    histogram_t ops[NUM_OPERATIONS][2];
+
+    /// Service times (excluding queueing delay) in open-loop mode.
+    histogram_t service;
+
+    /// Latencies of whole batches when batching.
+    histogram_t batch;
+
+    /**
+     * @brief Record latency of a completed operation.
+     *
+     * @param op type of the operation.
+     * @param succeeded whether the operation succeeded.
+     * @param latency latency in timer ticks.
+     */
+    void record(operation_t op, bool succeeded, uint64_t latency) noexcept
+    {
+        ops[static_cast<size_t>(op)][succeeded].record(latency);
+    }
+};
+
+/**
+ * @brief Latency histograms of a single thread for the current sampling windows.
+ *
+ * Workers record into the slot of the current window, loaded (relaxed) when
+ * a request completes. At the end of window w the monitor thread makes w + 1
+ * current and drains (merges and resets) window w - 1, so:
+ * - a worker may keep recording into window w for one more window, which
+ *   covers a request that loaded the window just before it changed, but a
+ *   worker stalled for longer than a whole window between loading the window
+ *   and recording races with the drain;
+ * - the slot being drained is the one of window w + 2, which only becomes
+ *   current after the drain, as the monitor drains before moving on.
+ * A drain that ends after window w + 1 should have ended stretches that
+ * window, so its latencies are skipped.
+ */
+struct window_latency_stats_t
+{
+    /// Number of windows kept in flight.
+    static constexpr size_t SLOTS = 3;
+
+    /// Latencies indexed by [window % SLOTS][operation_t].
+    window_histogram_t ops[SLOTS][NUM_OPERATIONS];
+};
+
+/**
+ * @brief Latency summary of one operation type over a sampling window.
+ *
+ */
+struct window_percentiles_t
+{
+    /// Number of latencies observed.
+    uint64_t count = 0;
+
+    /// Percentiles and maximum (timer ticks while running, nanoseconds in result_t).
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * @brief Latency distribution summary, in nanoseconds.
+ *
+ */
+struct latency_summary_t
+{
+    /// Number of latencies observed.
+    uint64_t count = 0;
+
+    /// Arithmetic mean.
+    double mean = 0.0;
+
+    /// Minimum, percentiles and maximum.
+    uint64_t min = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t p9999 = 0;
+    uint64_t p99999 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * @brief Results of the worker threads running on one socket.
+ *
+ */
+struct socket_result_t
+{
+    /// Socket id.
+    uint32_t socket = 0;
+
+    /// Number of worker threads pinned to the socket.
+    uint32_t threads = 0;
+
+    /// Operation counters of those threads.
+    stats_t total;
+
+    /// Latencies of all operations of those threads.
+    latency_summary_t latency;
+};
+
+/**
+ * @brief Results of the load phase.
+ *
+ * Latencies are in nanoseconds.
+ */
+struct load_result_t
+{
+    /// Whether records were loaded (false if the load was skipped).
+    bool loaded = false;
+
+    /// How records were loaded.
+    load_mode_t mode = load_mode_t::INSERT;
+
+    /// Number of records to be loaded, and number actually loaded.
+    uint64_t records = 0;
+    uint64_t inserted = 0;
+
+    /// Time to generate and sort records before loading (bulk load only).
+    double sort_ms = 0.0;
+
+    /// Duration of the load in milliseconds.
+    double elapsed_ms = 0.0;
+
+    /// Growth of the resident memory during the load, and resident memory after it (Bytes).
+    int64_t memory_footprint = 0;
+    uint64_t resident_memory = 0;
+
+    /// Length of the sampling windows (milliseconds).
+    double sampling_ms = 0.0;
+
+    /// Records loaded in each sampling window.
+    std::vector<uint64_t> samples;
+
+    /// Insert latencies of each sampling window (empty without latency sampling).
+    std::vector<window_percentiles_t> sample_latencies;
+
+    /// Whether insert latency was sampled (insert load only).
+    bool has_latency = false;
+
+    /// Latencies of all inserts.
+    latency_summary_t latency;
+
+    /// Whether every record was looked up after loading.
+    bool verified = false;
+
+    /// Duration of the verification in milliseconds.
+    double verify_ms = 0.0;
+
+    /// Records not found by the verification.
+    uint64_t missing = 0;
+};
+
+/**
+ * @brief Throughput around a move of the hot set, in operations per second.
+ *
+ */
+struct hot_shift_result_t
+{
+    /// Number of windows after the move reported in 'after'.
+    static constexpr size_t WINDOWS = 3;
+
+    /// First sampling window with the new hot set.
+    uint64_t window = 0;
+
+    /// Throughput of the window before the move.
+    double before = 0.0;
+
+    /// Throughput of the first windows after the move (fewer if the run
+    /// ended or the hot set moved again).
+    std::vector<double> after;
+
+    /// Time from the move until the end of the first window with at least
+    /// 90% of the throughput before it (negative if none before the next move).
+    double recovery_ms = -1.0;
+};
+
+/**
+ * @brief Results of a single run.
+ *
+ * Everything reported at the end of a run, so it can be printed as text or
+ * written in a machine-readable format. Latencies are in nanoseconds.
+ */
+struct result_t
+{
+    /// Name of the workload phase (empty if not running a workload file).
+    std::string name;
+
+    /// Options used for the run.
+    options_t opt;
+
+    /// Duration of the run in milliseconds.
+    double elapsed_ms = 0.0;
+
+    /// Operation counters of the whole run.
+    stats_t total;
+
+    /// How far behind schedule the threads were when finished (open-loop only).
+    double schedule_lag_ms = 0.0;
+
+    /// Time taken to pre-generate requests, slowest thread (milliseconds).
+    double generation_ms = 0.0;
+
+    /// Per-thread time to generate a request (nanoseconds).
+    double generation_ns_per_op = 0.0;
+
+    /// Operation counters of each sampling window.
+    std::vector<stats_t> samples;
+
+    /// Latencies of each sampling window (empty without latency sampling).
+    std::vector<std::array<window_percentiles_t, NUM_OPERATIONS>> sample_latencies;
+
+    /// Moves of the hot set (moving HOTSPOT distribution only).
+    std::vector<hot_shift_result_t> hot_shifts;
+
+    /// Timer used to measure latency.
+    timer_source_t timer = timer_source_t::CHRONO;
+    double timer_ns_per_tick = 1.0;
+    uint64_t timer_min_overhead_ns = 0;
+    uint64_t timer_overhead_ns = 0;
+
+    /// Whether latency was sampled during the run.
+    bool has_latency = false;
+
+    /// Latencies of all operations.
+    latency_summary_t latency;
+
+    /// Latencies per operation type, overall and by outcome.
+    latency_summary_t op_latency[NUM_OPERATIONS];
+    latency_summary_t op_succeeded_latency[NUM_OPERATIONS];
+    latency_summary_t op_failed_latency[NUM_OPERATIONS];
+
+    /// Service times excluding queueing delay (open-loop only).
+    latency_summary_t service_latency;
+
+    /// Latencies of whole batches (batching only). Operations of a batch
+    /// are recorded above with the batch latency amortized over them.
+    latency_summary_t batch_latency;
+
+    /// CPU and NUMA node of each worker thread when it started (-1 if unknown).
+    std::vector<int> worker_cpus;
+    std::vector<int> worker_nodes;
+
+    /// CPU the monitor thread was pinned to (-1 if not pinned).
+    int monitor_cpu = -1;
+
+    /// Results by socket of the workers (empty if workers are not pinned).
+    std::vector<socket_result_t> sockets;
+
+    /// Whether PCM metrics were collected.
+    bool has_pcm = false;
+
+    /// PCM metrics, in bytes for memory traffic.
+    uint64_t l3_misses = 0;
+    uint64_t dram_reads = 0;
+    uint64_t dram_writes = 0;
+    uint64_t nvm_reads = 0;
+    uint64_t nvm_writes = 0;
 };
 
 class benchmark_t
@@ -189,28 +862,116 @@ public:
     /**
      * @brief Load the tree with the amount of records specified in options_t.
      *
-     * A single thread is used for load phase to guarantee determinism across
-     * multiple runs. Using multiple threads can lead to different, but
-     * equivalent, results.
+     * Insert loads use all threads, each inserting a static share of the
+     * ids (contiguous ranges, or round-robin when keys are ordered), so the
+     * same records are loaded on every run although the interleaving of
+     * inserts differs. Bulk loads generate and sort the records with all
+     * threads, then hand them to bulk_load() from a single thread.
+     *
+     * Results are printed to stdout, and returned to be written in other
+     * formats.
+     *
+     * @return load_result_t
+     */
+    load_result_t load() noexcept;
+
+    /**
+     * @brief Run the workload as specified by options_t.
+     *
+     * Results are printed to stdout as they have always been, and returned
+     * to be written in other formats.
+     *
+     * @return result_t
+     */
+    result_t run() noexcept;
+
+    /**
+     * @brief Change the workload used by the following calls to run().
+     *
+     * Records loaded or inserted by previous runs are kept, so several
+     * workload phases can be executed back-to-back against the same tree.
+     *
+     * @param opt options of the following runs.
      */
-    void load() noexcept;
+    void configure(const options_t& opt);
 
-    /// Run the workload as specified by options_t.
-    void run() noexcept;
+    /**
+     * @brief Generate the keys of all records to be loaded and sort them,
+     * in parallel.
+     *
+     * @param cpus CPUs to pin the threads to (empty if not pinning).
+     * @param keys[out] keys of all records, in the order generated.
+     * @param sorted[out] pointers into 'keys', in lexicographic order.
+     */
+    void sort_records(const std::vector<uint32_t>& cpus, std::vector<char>& keys,
+                      std::vector<const char*>& sorted);
 
     /// Maximum number of records to be scanned.
     static constexpr size_t MAX_SCAN = 1000;
 
+    /// Maximum number of operations per batch.
+    static constexpr size_t MAX_BATCH = 1024;
+
+    /// Maximum number of interleaved lookups per thread.
+    static constexpr size_t MAX_INTERLEAVE = 64;
+
+    /// Shortest sampling window in milliseconds.
+    static constexpr double MIN_SAMPLING_MS = 0.01;
+
+    /// Maximum number of sampling windows allocated before a run.
+    static constexpr size_t MAX_WINDOWS = 1 << 20;
+
 private:
-    void run_op(operation_t op, const char *key_ptr, 
+    /**
+     * @brief Execute a single operation against the tree.
+     *
+     * @param value_size size of the value written by inserts and updates.
+     * @param scan_size number of records read by scans.
+     * @return true if the operation succeeded.
+     * @return false if the operation failed (e.g., key not found).
+     */
+    bool run_op(operation_t op, const char *key_ptr,
+                uint32_t value_size, uint32_t scan_size,
                 char *value_out, char *values_out, bool measure_latency,
-                stats_t &stats);
+                thread_stats_t &stats);
+
+    /**
+     * @brief Execute a batch of reads or inserts against the tree.
+     *
+     * @param num number of operations in the batch.
+     * @param values values to be inserted (unused by reads).
+     * @param values_out buffers for the values read (unused by inserts).
+     * @param succeeded[out] outcome of each operation.
+     * @return size_t number of operations that succeeded.
+     */
+    size_t run_batch(operation_t op, size_t num, const char* const* keys,
+                     const char* const* values, uint32_t value_size,
+                     char* const* values_out, bool* succeeded,
+                     thread_stats_t &stats);
+
+    /// Print results of a run in human-readable form.
+    void print_result(const result_t& result) const;
+
+    /// Print results of the load in human-readable form.
+    void print_load_result(const load_result_t& result) const;
+
+    /// Summarize a histogram of latencies in timer ticks, in nanoseconds.
+    latency_summary_t summarize(const histogram_t& h) const;
+
+    /// CPU of each of the given number of threads (empty if not pinning).
+    std::vector<uint32_t> placement(uint32_t num_threads) const;
+
+    /// Topology of the given CPU (nullptr if unknown).
+    const cpu_t* cpu_info(int cpu) const;
+
+    /// Set memory policy of the calling thread, if memory placement is used.
+    void set_mempolicy(mempolicy_t policy) const;
 
     /// Tree data structure being benchmarked.
     tree_api* tree_;
 
     /// Options used to run this benchmark.
-    const options_t opt_;
+    options_t opt_;
 
     /// Operation generator.
     operation_generator_t op_generator_;
@@ -218,17 +979,38 @@ private:
     /// Key generator.
     std::unique_ptr<key_generator_t> key_generator_;
 
+    /// Timer used to measure latency of requests.
+    latency_timer_t timer_;
+
+    /// Next id to be used for inserts (ids in [1, next_insert_id_) are taken).
+    uint64_t next_insert_id_;
+
+    /// Number of MONOTONIC key streams, fixed by the threads of the first
+    /// configuration so keys of existing records do not change.
+    uint32_t key_streams_;
+
     /// Value generator.
     value_generator_t value_generator_;
 
     /// Intel PCM handler.
     PCM* pcm_;
+
+    /// CPUs of the machine.
+    std::vector<cpu_t> topology_;
 };
 } // namespace PiBench
 
 namespace std
 {
 std::ostream& operator<<(std::ostream& os, const PiBench::distribution_t& dist);
+std::ostream& operator<<(std::ostream& os, const PiBench::operation_t& op);
+std::ostream& operator<<(std::ostream& os, const PiBench::timer_source_t& source);
+std::ostream& operator<<(std::ostream& os, const PiBench::hot_shift_t& shift);
+std::ostream& operator<<(std::ostream& os, const PiBench::arrival_t& arrival);
+std::ostream& operator<<(std::ostream& os, const PiBench::scan_length_t& length);
+std::ostream& operator<<(std::ostream& os, const PiBench::load_mode_t& mode);
+std::ostream& operator<<(std::ostream& os, const PiBench::key_order_t& order);
+std::ostream& operator<<(std::ostream& os, const PiBench::key_encoding_t& encoding);
 std::ostream& operator<<(std::ostream& os, const PiBench::options_t& opt);
 } // namespace std
 
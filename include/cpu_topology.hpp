@@ -0,0 +1,186 @@
+#ifndef __CPU_TOPOLOGY_HPP__
+#define __CPU_TOPOLOGY_HPP__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace PiBench
+{
+
+/**
+ * @brief Location of a logical CPU in the machine.
+ *
+ */
+struct cpu_t
+{
+    /// Logical CPU id as used by the operating system.
+    uint32_t id = 0;
+
+    /// Physical core id (unique within a socket).
+    uint32_t core = 0;
+
+    /// Physical package (socket) id.
+    uint32_t socket = 0;
+
+    /// NUMA node the CPU belongs to.
+    uint32_t node = 0;
+
+    /// Rank of this CPU among the SMT siblings of its core (0 for the first).
+    uint32_t sibling = 0;
+};
+
+/**
+ * @brief Policies to place worker threads on CPUs.
+ *
+ */
+enum class affinity_t : uint8_t
+{
+    /// Threads are not pinned, the operating system decides.
+    NONE = 0,
+
+    /// Fill a socket (including SMT siblings) before moving to the next.
+    COMPACT = 1,
+
+    /// Spread threads round-robin across sockets, one per core first.
+    SCATTER = 2,
+
+    /// One thread per physical core before using any SMT sibling.
+    CORES = 3,
+
+    /// Explicit list of CPUs.
+    LIST = 4
+};
+
+/**
+ * @brief NUMA memory placement policies.
+ *
+ */
+enum class mempolicy_t : uint8_t
+{
+    /// System default (allocate on the node of the CPU touching the memory).
+    DEFAULT = 0,
+
+    /// Allocate on the node of the thread touching the memory first.
+    LOCAL = 1,
+
+    /// Interleave pages round-robin across the given nodes.
+    INTERLEAVE = 2,
+
+    /// Allocate only from the given nodes.
+    BIND = 3
+};
+
+/**
+ * @brief Parse affinity policy from its (case insensitive) name.
+ *
+ * @param name one of "none", "compact", "scatter", "cores" or "list".
+ * @param affinity parsed policy.
+ * @return true if the name is valid.
+ * @return false otherwise.
+ */
+bool parse_affinity(std::string name, affinity_t& affinity);
+
+/**
+ * @brief Parse memory policy from its (case insensitive) name.
+ *
+ * @param name one of "default", "local", "interleave" or "bind".
+ * @param policy parsed policy.
+ * @return true if the name is valid.
+ * @return false otherwise.
+ */
+bool parse_mempolicy(std::string name, mempolicy_t& policy);
+
+/**
+ * @brief Parse list of CPUs in the format used by the kernel (e.g., "0-3,8,10-11").
+ *
+ * @param list text to be parsed.
+ * @param cpus parsed CPU ids, in the given order.
+ * @return true if the list is valid.
+ * @return false otherwise.
+ */
+bool parse_cpu_list(const std::string& list, std::vector<uint32_t>& cpus);
+
+/**
+ * @brief Read topology of the online CPUs from sysfs.
+ *
+ * If sysfs is not available, every CPU reported by the standard library is
+ * assumed to be a separate core of a single socket.
+ *
+ * @return std::vector<cpu_t> CPUs sorted by id.
+ */
+std::vector<cpu_t> read_topology();
+
+/// NUMA nodes that have CPUs, in ascending order.
+std::vector<uint32_t> numa_nodes(const std::vector<cpu_t>& topology);
+
+/**
+ * @brief Choose a CPU for each worker thread.
+ *
+ * If there are more threads than CPUs available to the policy, CPUs are
+ * reused in the same order.
+ *
+ * @param topology CPUs of the machine.
+ * @param policy placement policy, must not be NONE.
+ * @param num_threads number of worker threads.
+ * @param cpu_list CPUs to be used by the LIST policy.
+ * @return std::vector<uint32_t> CPU id of each thread.
+ */
+std::vector<uint32_t> place_threads(const std::vector<cpu_t>& topology, affinity_t policy,
+                                    uint32_t num_threads, const std::vector<uint32_t>& cpu_list);
+
+/**
+ * @brief Choose a CPU for the monitor thread that does not disturb workers.
+ *
+ * Prefers a CPU of a core with no worker, then an unused SMT sibling of a
+ * worker.
+ *
+ * @param topology CPUs of the machine.
+ * @param placement CPU of each worker thread.
+ * @return int CPU id, or -1 if every CPU runs a worker.
+ */
+int pick_monitor_cpu(const std::vector<cpu_t>& topology, const std::vector<uint32_t>& placement);
+
+/**
+ * @brief Pin the calling thread to a single CPU.
+ *
+ * @param cpu
+ * @return true on success.
+ * @return false otherwise.
+ */
+bool pin_thread(uint32_t cpu);
+
+/**
+ * @brief Restrict the calling thread to a set of CPUs.
+ *
+ * @param cpus
+ * @return true on success.
+ * @return false otherwise.
+ */
+bool pin_thread(const std::vector<uint32_t>& cpus);
+
+/// CPU the calling thread is currently running on, -1 if unknown.
+int current_cpu();
+
+/**
+ * @brief Set the memory policy of the calling thread.
+ *
+ * Applies to pages the thread touches for the first time from now on,
+ * including memory allocated by other threads.
+ *
+ * @param policy
+ * @param nodes nodes used by INTERLEAVE and BIND, ignored otherwise.
+ * @return true on success.
+ * @return false otherwise (e.g., kernel without NUMA support).
+ */
+bool apply_mempolicy(mempolicy_t policy, const std::vector<uint32_t>& nodes);
+
+} // namespace PiBench
+
+namespace std
+{
+std::ostream& operator<<(std::ostream& os, const PiBench::affinity_t& affinity);
+std::ostream& operator<<(std::ostream& os, const PiBench::mempolicy_t& policy);
+} // namespace std
+#endif
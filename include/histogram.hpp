@@ -0,0 +1,189 @@
+#ifndef __HISTOGRAM_HPP__
+#define __HISTOGRAM_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace PiBench
+{
+
+/**
+ * @brief Fixed-size, log-bucketed histogram of unsigned integer values.
+ *
+ * The layout follows the idea of HdrHistogram: values are grouped by their
+ * most significant bit and each power of two is further divided into
+ * 2^SUB_BITS linear sub-buckets. This bounds the relative error of any
+ * reported value to 2^-SUB_BITS (~0.8% with 7 bits), while the memory
+ * footprint is constant regardless of how many values are recorded.
+ *
+ * Values larger than 2^MAX_BITS are accounted in the last bucket, but the
+ * exact maximum is still tracked separately.
+ *
+ * Recording a value never allocates, so histograms are safe to be used in the
+ * hot path of the benchmark. Each thread is expected to record into its own
+ * instance, which are then merged at the end of the run.
+ *
+ * @tparam SUB_BITS_ number of bits used for the linear sub-buckets.
+ * @tparam MAX_BITS_ number of bits of the largest value tracked with bounded error.
+ */
+template <uint32_t SUB_BITS_, uint32_t MAX_BITS_ = 40>
+class alignas(64) basic_histogram_t
+{
+public:
+    /// Number of bits used for the linear sub-buckets of each power of two.
+    static constexpr uint32_t SUB_BITS = SUB_BITS_;
+
+    /// Number of bits of the largest value tracked with bounded error.
+    static constexpr uint32_t MAX_BITS = MAX_BITS_;
+
+    /// Number of sub-buckets per power of two.
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+
+    /// Total number of buckets.
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    basic_histogram_t() noexcept
+    {
+        reset();
+    }
+
+    /**
+     * @brief Record a single value.
+     *
+     * @param v value to be recorded.
+     */
+    void record(uint64_t v) noexcept
+    {
+        ++counts_[index(v)];
+        ++count_;
+        sum_ += v;
+        min_ = std::min(min_, v);
+        max_ = std::max(max_, v);
+    }
+
+    /**
+     * @brief Add all values recorded by another histogram to this one.
+     *
+     * @param other
+     */
+    void merge(const basic_histogram_t& other) noexcept
+    {
+        for (size_t i = 0; i < BUCKETS; ++i)
+            counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    /**
+     * @brief Discard all recorded values.
+     *
+     */
+    void reset() noexcept
+    {
+        counts_.fill(0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+    }
+
+    /// Number of recorded values.
+    uint64_t count() const noexcept { return count_; }
+
+    /// Smallest recorded value (0 if empty).
+    uint64_t min() const noexcept { return count_ ? min_ : 0; }
+
+    /// Largest recorded value (0 if empty).
+    uint64_t max() const noexcept { return max_; }
+
+    /// Arithmetic mean of the recorded values (0 if empty).
+    double mean() const noexcept { return count_ ? double(sum_) / count_ : 0.0; }
+
+    /**
+     * @brief Returns the value at the given percentile.
+     *
+     * The returned value is the upper bound of the bucket holding the
+     * requested rank, clamped to the range of recorded values.
+     *
+     * @param p percentile in the range [0.0, 1.0].
+     * @return uint64_t
+     */
+    uint64_t percentile(double p) const noexcept
+    {
+        if (count_ == 0)
+            return 0;
+
+        uint64_t rank = std::min<uint64_t>(p * count_, count_ - 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += counts_[i];
+            if (seen > rank)
+                return std::clamp(upper_bound(i), min(), max());
+        }
+        return max();
+    }
+
+private:
+    /**
+     * @brief Returns bucket index of given value.
+     *
+     * Values smaller than SUB_COUNT map directly to their own bucket. Larger
+     * values are shifted so that their SUB_BITS+1 most significant bits select
+     * the sub-bucket within the range of their most significant bit.
+     */
+    static size_t index(uint64_t v) noexcept
+    {
+        if (v < SUB_COUNT)
+            return v;
+
+        uint32_t msb = 63 - __builtin_clzll(v);
+        if (msb >= MAX_BITS)
+            return BUCKETS - 1;
+
+        uint32_t shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + ((v >> shift) - SUB_COUNT);
+    }
+
+    /// Returns the largest value that maps to the given bucket.
+    static uint64_t upper_bound(size_t i) noexcept
+    {
+        if (i < SUB_COUNT)
+            return i;
+
+        // Last bucket also holds every value beyond 2^MAX_BITS.
+        if (i == BUCKETS - 1)
+            return std::numeric_limits<uint64_t>::max();
+
+        uint32_t shift = i / SUB_COUNT - 1;
+        uint64_t sub = i % SUB_COUNT + SUB_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    /// Number of values recorded in each bucket.
+    std::array<uint64_t, BUCKETS> counts_;
+
+    /// Total number of values recorded.
+    uint64_t count_;
+
+    /// Sum of all values recorded.
+    uint64_t sum_;
+
+    /// Smallest value recorded.
+    uint64_t min_;
+
+    /// Largest value recorded.
+    uint64_t max_;
+};
+
+/// Histogram used for whole-run latencies (~0.8% relative error, 34 KiB).
+using histogram_t = basic_histogram_t<7>;
+
+/// Coarser histogram used for short windows (~3% relative error, 9 KiB).
+using window_histogram_t = basic_histogram_t<5>;
+} // namespace PiBench
+#endif
@@ -2,8 +2,12 @@
 #define __KEY_GENERATOR_HPP__
 
 #include "selfsimilar_int_distribution.hpp"
+#include "utils.hpp"
+#include "xoshiro256pp_engine.hpp"
 #include "zipfian_int_distribution.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
@@ -13,6 +17,43 @@
 namespace PiBench
 {
 
+/**
+ * @brief How record ids are mapped to keys, which sets the order in which
+ * keys are inserted.
+ *
+ */
+enum class key_order_t : uint8_t
+{
+    /// Ids are scrambled by a multiplicative hash (random order).
+    HASHED = 0,
+
+    /// Keys are the ids themselves (ascending order).
+    SEQUENTIAL = 1,
+
+    /// Keys decrease as ids grow (descending order).
+    REVERSE = 2,
+
+    /// Ascending, but every key is displaced by less than a given distance.
+    KSORTED = 3,
+
+    /// Ids are dealt round-robin to streams in disjoint key ranges, each
+    /// ascending (one stream per thread).
+    MONOTONIC = 4
+};
+
+/**
+ * @brief Byte order in which ids are stored in keys.
+ *
+ */
+enum class key_encoding_t : uint8_t
+{
+    /// Host byte order, as a plain integer.
+    NATIVE = 0,
+
+    /// Most significant Byte first, so memcmp order is numeric order.
+    BIGENDIAN = 1
+};
+
 /**
  * @brief Class used to generate random keys of a given size belonging to a
  * keyspace of given size.
@@ -21,11 +62,16 @@ namespace PiBench
  * |----- prefix (optional) -----||---- id -----|
  *
  * The generated 'ids' are 8 Byte unsigned integers. The 'ids' are then hashed
- * to scramble the keys across the keyspace.
+ * to scramble the keys across the keyspace, unless another key order is set.
+ *
+ * If the specified key size is smaller than 8 Bytes, ids are scrambled by a
+ * permutation of that many bits, so the first 2^(8*size) ids map to distinct
+ * keys, and the higher bits are discarded. If the specified key size is
+ * larger than 8 Bytes, zeroes are preppended to match the size.
  *
- * If the specified key size is smaller than 8 Bytes, the higher bits are
- * discarded. If the specified key size is larger than 8 Bytes, zeroes are
- * preppended to match the size.
+ * Ids are stored in host byte order, or most significant Byte first with the
+ * BIGENDIAN encoding. Then keys (including any prefix, which is the same for
+ * every key) sort by memcmp in the numeric order of the stored ids.
  *
  */
 class key_generator_t
@@ -58,6 +104,26 @@ public:
      */
     virtual const char* next(bool in_sequence = false) final;
 
+    /**
+     * @brief Generate next random key, materializing BATCH_SIZE keys at a time.
+     *
+     * Returns the same keys as next(false) for the same seed, as long as the
+     * ids of this thread are only drawn through this function. The ids of a
+     * whole batch are drawn and turned into keys together into a per-thread
+     * buffer, so the distribution and the hash run in tight loops instead of
+     * through one virtual call per key.
+     *
+     * The pointer returned should not be used across calls to next_batched().
+     *
+     * @return const char* pointer to beginning of key.
+     */
+    const char* next_batched()
+    {
+        if (batch_pos_ == batch_count_)
+            fill_batch();
+        return &batch_buf_[batch_pos_++ * size()];
+    }
+
     /**
      * @brief Returns total key size (including prefix).
      *
@@ -81,6 +147,7 @@ public:
     {
         seed_ = seed;
         generator_.seed(seed_);
+        batch_pos_ = batch_count_ = 0;
     }
 
     /**
@@ -92,24 +159,109 @@ public:
 
     static constexpr uint32_t KEY_MAX = 128;
 
+    /// Number of keys materialized together by next_batched().
+    static constexpr uint32_t BATCH_SIZE = 16;
+
     static thread_local uint64_t current_id_;
 
     const char* hash_id(uint64_t id);
 
+    /**
+     * @brief Materialize the keys of several ids at once.
+     *
+     * Keys of 8 Bytes without prefix, hashed and in native byte order take a
+     * specialized path the compiler vectorizes.
+     *
+     * @param ids
+     * @param count
+     * @param out destination of 'count' keys of size() Bytes each, back to back.
+     */
+    void hash_ids(const uint64_t* ids, size_t count, char* out);
+
+    /**
+     * @brief Set how ids are mapped to keys (hashed by default).
+     *
+     * @param order
+     * @param displacement maximum displacement of KSORTED keys, at least 1.
+     * @param streams number of MONOTONIC streams, at least 1.
+     */
+    void set_order(key_order_t order, uint64_t displacement = 1, uint32_t streams = 1) noexcept
+    {
+        order_ = order;
+        displacement_ = displacement;
+        streams_ = streams;
+    }
+
+    /**
+     * @brief Map an id to the integer stored in its key, according to the key order.
+     *
+     * @param id
+     * @return uint64_t
+     */
+    uint64_t order_id(uint64_t id) const noexcept;
+
+    /**
+     * @brief Id of the key at the given position in key order, counting
+     * from the key of id 1 (the identity, unless keys are MONOTONIC).
+     *
+     * @param rank position in range [1, N].
+     * @return uint64_t
+     */
+    uint64_t key_rank_id(uint64_t rank) const noexcept;
+
+    /**
+     * @brief Set the byte order of ids in keys (native by default).
+     *
+     */
+    void set_encoding(key_encoding_t encoding) noexcept { encoding_ = encoding; }
+
+    /**
+     * @brief Store an id in 'size' Bytes the same way generated keys do.
+     *
+     * @param id
+     * @param ptr destination of 'size' Bytes.
+     * @param size
+     * @param encoding
+     */
+    static void store_id(uint64_t id, char* ptr, size_t size, key_encoding_t encoding = key_encoding_t::NATIVE) noexcept;
+
     virtual uint64_t next_id() = 0;
 
+    /**
+     * @brief Draw 'count' ids, same as calling next_id() 'count' times.
+     *
+     */
+    virtual void next_ids(uint64_t* ids, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = next_id();
+    }
+
 protected:
 
     /// Engine used for generating random numbers.
-    static thread_local std::default_random_engine generator_;
+    static thread_local xoshiro256pp_engine generator_;
 
 private:
+    /// Draw and materialize the next BATCH_SIZE keys.
+    void fill_batch();
+
+    /// Hash 8 Byte ids into 8 Byte native keys.
+    static void hash_ids_u64(const uint64_t* ids, size_t count, char* out) noexcept;
+
     /// Seed used for generating random numbers.
     static thread_local uint32_t seed_;
 
     /// Space to materialize the keys (avoid allocation).
     static thread_local char buf_[KEY_MAX];
 
+    /// Keys materialized by next_batched().
+    static thread_local char batch_buf_[BATCH_SIZE * KEY_MAX];
+
+    /// Position of next key in batch_buf_, and number of keys in it.
+    static thread_local uint32_t batch_pos_;
+    static thread_local uint32_t batch_count_;
+
     /// Size of keyspace to generate keys.
     const size_t N_;
 
@@ -119,6 +271,18 @@ private:
     /// Prefix to be preppended to every key.
     const std::string prefix_;
 
+    /// How ids are mapped to keys.
+    key_order_t order_ = key_order_t::HASHED;
+
+    /// Maximum displacement of KSORTED keys.
+    uint64_t displacement_ = 1;
+
+    /// Number of MONOTONIC streams.
+    uint32_t streams_ = 1;
+
+    /// Byte order of ids in keys.
+    key_encoding_t encoding_ = key_encoding_t::NATIVE;
+
     //uint64_t current_id_ = 0;
 };
 
@@ -135,6 +299,12 @@ protected:
         return dist_(generator_);
     }
 
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = dist_(generator_);
+    }
+
 private:
     std::uniform_int_distribution<uint64_t> dist_;
 };
@@ -153,6 +323,12 @@ public:
         return dist_(generator_);
     }
 
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = dist_(generator_);
+    }
+
 private:
     selfsimilar_int_distribution<uint64_t> dist_;
 };
@@ -171,8 +347,170 @@ public:
         return dist_(generator_);
     }
 
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = dist_(generator_);
+    }
+
+private:
+    zipfian_int_distribution<uint64_t> dist_;
+};
+
+/**
+ * @brief Zipfian popularity spread over the keyspace (YCSB's scrambled
+ * zipfian), so the hottest ids are not the first ones loaded.
+ *
+ * Ranks are mapped to ids by a permutation of [1, N], so every rank still
+ * has its own id.
+ */
+class scrambled_zipfian_key_generator_t final : public key_generator_t
+{
+public:
+    scrambled_zipfian_key_generator_t(size_t N, size_t size, const std::string& prefix = "", float skew = 0.99)
+        : key_generator_t(N, size, prefix),
+          dist_(1, N, skew),
+          bits_(2)
+    {
+        // Smallest even number of bits covering the ids
+        while (bits_ < 64 && (1ull << bits_) < N)
+            bits_ += 2;
+    }
+
+    virtual uint64_t next_id() override
+    {
+        return scramble(dist_(generator_));
+    }
+
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = scramble(dist_(generator_));
+    }
+
+private:
+    uint64_t scramble(uint64_t rank) const noexcept
+    {
+        // Walk the cycle of the permutation until landing in [0, N), which
+        // takes fewer than 4 steps on average.
+        uint64_t x = rank - 1;
+        do
+        {
+            x = utils::feistel_permute(x, bits_);
+        } while (x >= keyspace());
+        return x + 1;
+    }
+
+    zipfian_int_distribution<uint64_t> dist_;
+
+    /// Width of the permutation.
+    uint32_t bits_;
+};
+
+/**
+ * @brief Zipfian popularity clustered in key order, so the hottest keys are
+ * neighbors (e.g., share leaf nodes).
+ *
+ * The hottest rank is the key of id 1 and the following ranks are the next
+ * keys in key order, which requires a key order other than HASHED.
+ */
+class clustered_zipfian_key_generator_t final : public key_generator_t
+{
+public:
+    clustered_zipfian_key_generator_t(size_t N, size_t size, const std::string& prefix = "", float skew = 0.99)
+        : key_generator_t(N, size, prefix),
+          dist_(1, N, skew) {}
+
+    virtual uint64_t next_id() override
+    {
+        return key_rank_id(dist_(generator_));
+    }
+
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = key_rank_id(dist_(generator_));
+    }
+
 private:
     zipfian_int_distribution<uint64_t> dist_;
 };
+/**
+ * @brief A fraction of the operations on a hot set of the keyspace, the rest
+ * spread uniformly over the other keys (YCSB's hotspot).
+ *
+ * The hot set is a window of consecutive ranks starting at hot_start(),
+ * wrapping around the end of the keyspace. Ranks are mapped to ids like in
+ * clustered_zipfian_key_generator_t, so with a key order other than HASHED
+ * the hot set is a range of keys. The window can be moved by another thread
+ * while keys are being generated.
+ */
+class hotspot_key_generator_t final : public key_generator_t
+{
+public:
+    hotspot_key_generator_t(size_t N, size_t size, const std::string& prefix = "", double hot_set = 0.2, double hot_ops = 0.8)
+        : key_generator_t(N, size, prefix),
+          hot_size_(std::min<uint64_t>(N, std::max<int64_t>(1, std::llround(hot_set * N)))),
+          hot_ops_(hot_size_ < N ? hot_ops : 1.0),
+          hot_dist_(0, hot_size_ - 1),
+          cold_dist_(0, hot_size_ < N ? N - hot_size_ - 1 : 0)
+    {
+    }
+
+    virtual uint64_t next_id() override
+    {
+        return draw(hot_start_.load(std::memory_order_relaxed));
+    }
+
+    virtual void next_ids(uint64_t* ids, size_t count) override
+    {
+        uint64_t start = hot_start_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i)
+            ids[i] = draw(start);
+    }
+
+    /**
+     * @brief Number of keys in the hot set.
+     *
+     */
+    uint64_t hot_size() const noexcept { return hot_size_; }
+
+    /**
+     * @brief Rank offset (from 0) where the hot set starts.
+     *
+     */
+    uint64_t hot_start() const noexcept { return hot_start_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Move the hot set, taking effect on the next keys generated.
+     *
+     * @param start rank offset, taken modulo the keyspace.
+     */
+    void set_hot_start(uint64_t start) noexcept { hot_start_.store(start % keyspace(), std::memory_order_relaxed); }
+
+private:
+    uint64_t draw(uint64_t start)
+    {
+        // Cold keys follow the hot set, so both are contiguous modulo N
+        uint64_t offset = op_dist_(generator_) < hot_ops_ ? hot_dist_(generator_) : hot_size_ + cold_dist_(generator_);
+        uint64_t rank = start + offset;
+        if (rank >= keyspace())
+            rank -= keyspace();
+        return key_rank_id(rank + 1);
+    }
+
+    /// Number of keys in the hot set.
+    const uint64_t hot_size_;
+
+    /// Fraction of keys drawn from the hot set.
+    const double hot_ops_;
+
+    /// Rank offset where the hot set starts.
+    std::atomic<uint64_t> hot_start_{0};
+
+    std::uniform_real_distribution<double> op_dist_;
+    std::uniform_int_distribution<uint64_t> hot_dist_;
+    std::uniform_int_distribution<uint64_t> cold_dist_;
+};
 } // namespace PiBench
 #endif
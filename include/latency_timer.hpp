@@ -0,0 +1,163 @@
+#ifndef __LATENCY_TIMER_HPP__
+#define __LATENCY_TIMER_HPP__
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PIBENCH_HAS_TSC 1
+#else
+#define PIBENCH_HAS_TSC 0
+#endif
+
+namespace PiBench
+{
+
+/**
+ * @brief Clock sources available for measuring latency.
+ *
+ */
+enum class timer_source_t : uint8_t
+{
+    CHRONO = 0,
+    TSC = 1
+};
+
+/**
+ * @brief Timer used to measure the latency of individual requests.
+ *
+ * Timestamps are returned as opaque ticks and are only converted to
+ * nanoseconds when reporting, so the hot path never does floating point
+ * arithmetic.
+ *
+ * The CHRONO source relies on std::chrono::high_resolution_clock and ticks
+ * are nanoseconds. The TSC source reads the invariant time stamp counter
+ * directly with rdtsc/rdtscp, fenced so that the measured code cannot be
+ * reordered around the reads. Its frequency is calibrated once against the
+ * steady clock when the timer is constructed.
+ *
+ * The cost of taking a start/stop pair back-to-back is also measured at
+ * construction, so it can be reported and optionally subtracted from every
+ * measurement.
+ */
+class latency_timer_t
+{
+public:
+    /**
+     * @brief Construct a new latency_timer_t object.
+     *
+     * Calibrates the tick frequency and measures the timer overhead.
+     *
+     * @param source clock source to be used.
+     */
+    explicit latency_timer_t(timer_source_t source = timer_source_t::CHRONO);
+
+    /**
+     * @brief Take timestamp at the beginning of a measured region.
+     *
+     * @return uint64_t ticks.
+     */
+    uint64_t start() const noexcept
+    {
+#if PIBENCH_HAS_TSC
+        if (source_ == timer_source_t::TSC)
+        {
+            _mm_lfence();
+            uint64_t t = __rdtsc();
+            _mm_lfence();
+            return t;
+        }
+#endif
+        return now();
+    }
+
+    /**
+     * @brief Take timestamp at the end of a measured region.
+     *
+     * rdtscp waits for all previous instructions to retire before reading
+     * the counter and the following fence keeps later instructions from
+     * starting before the read.
+     *
+     * @return uint64_t ticks.
+     */
+    uint64_t stop() const noexcept
+    {
+#if PIBENCH_HAS_TSC
+        if (source_ == timer_source_t::TSC)
+        {
+            unsigned int aux;
+            uint64_t t = __rdtscp(&aux);
+            _mm_lfence();
+            return t;
+        }
+#endif
+        return now();
+    }
+
+    /**
+     * @brief Convert ticks to nanoseconds.
+     *
+     * @param ticks
+     * @return double
+     */
+    double to_ns(uint64_t ticks) const noexcept { return ticks * ns_per_tick_; }
+
+    /**
+     * @brief Convert nanoseconds to ticks.
+     *
+     * @param ns
+     * @return uint64_t
+     */
+    uint64_t to_ticks(double ns) const noexcept { return ns / ns_per_tick_; }
+
+    /// Clock source used by this timer.
+    timer_source_t source() const noexcept { return source_; }
+
+    /// Duration of a tick in nanoseconds.
+    double ns_per_tick() const noexcept { return ns_per_tick_; }
+
+    /// Median cost in ticks of a back-to-back start()/stop() pair.
+    uint64_t overhead() const noexcept { return overhead_; }
+
+    /// Minimum cost in ticks of a back-to-back start()/stop() pair.
+    uint64_t min_overhead() const noexcept { return min_overhead_; }
+
+    /**
+     * @brief Check if the CPU provides an invariant time stamp counter.
+     *
+     * An invariant TSC ticks at a constant rate regardless of frequency
+     * scaling and power states, and is synchronized across cores.
+     *
+     * @return true
+     * @return false
+     */
+    static bool tsc_supported() noexcept;
+
+private:
+    static uint64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    }
+
+    /// Estimate duration of a tick against the steady clock.
+    void calibrate();
+
+    /// Measure cost of taking timestamps.
+    void measure_overhead();
+
+    /// Clock source.
+    timer_source_t source_;
+
+    /// Duration of a tick in nanoseconds.
+    double ns_per_tick_;
+
+    /// Median overhead in ticks.
+    uint64_t overhead_;
+
+    /// Minimum overhead in ticks.
+    uint64_t min_overhead_;
+};
+} // namespace PiBench
+#endif
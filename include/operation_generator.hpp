@@ -1,6 +1,8 @@
 #ifndef __OPERATION_GENERATOR_HPP__
 #define __OPERATION_GENERATOR_HPP__
 
+#include "xoshiro256pp_engine.hpp"
+
 #include <cstdint>
 #include <random>
 #include <array>
@@ -14,9 +16,15 @@ enum class operation_t : uint8_t
     INSERT = 1,
     UPDATE = 2,
     REMOVE = 3,
-    SCAN = 4
+    SCAN = 4,
+
+    /// Read a record and write it back (YCSB's read-modify-write).
+    READ_MODIFY_WRITE = 5
 };
 
+/// Number of different operation types.
+static constexpr size_t NUM_OPERATIONS = 6;
+
 class operation_generator_t
 {
 public:
@@ -28,11 +36,12 @@ public:
      * @param update ratio of update operations.
      * @param remove ratio of remove operations.
      * @param scan ratio of scan operations.
+     * @param rmw ratio of read-modify-write operations.
      */
-    operation_generator_t(float read, float insert, float update, float remove, float scan)
+    operation_generator_t(float read, float insert, float update, float remove, float scan, float rmw = 0.0)
     {
         std::default_random_engine gen;
-        std::discrete_distribution<uint32_t> op_weights({read, insert, update, remove, scan});
+        std::discrete_distribution<uint32_t> op_weights({read, insert, update, remove, scan, rmw});
 
         for(unsigned int i=0; i<ops_.size(); ++i) {
             ops_[i] = static_cast<operation_t>(op_weights(gen));
@@ -72,7 +81,7 @@ private:
     static thread_local uint32_t seed_;
 
     /// Engine used for generation random numbers.
-    static thread_local std::default_random_engine gen_;
+    static thread_local xoshiro256pp_engine gen_;
 
     /// Weighted distribution for generating random numbers.
     std::uniform_int_distribution<uint32_t> dist_;
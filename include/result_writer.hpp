@@ -0,0 +1,68 @@
+#ifndef __RESULT_WRITER_HPP__
+#define __RESULT_WRITER_HPP__
+
+#include "benchmark.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace PiBench
+{
+
+/**
+ * @brief Formats in which results can be written.
+ *
+ */
+enum class output_format_t : uint8_t
+{
+    TEXT = 0,
+    JSON = 1,
+    CSV = 2
+};
+
+/**
+ * @brief Parse output format from its (case insensitive) name.
+ *
+ * @param name one of "text", "json" or "csv".
+ * @param format parsed format.
+ * @return true if the name is valid.
+ * @return false otherwise.
+ */
+bool parse_output_format(std::string name, output_format_t& format);
+
+/**
+ * @brief Write environment and results as a single JSON document.
+ *
+ * The document has an "environment" object and a "runs" array, with one
+ * entry per run (or workload phase) holding its options, throughput,
+ * latency percentiles, per-window samples and PCM metrics. If records were
+ * loaded, a "load" object holds the results of the load phase.
+ *
+ * @param os stream to write to.
+ * @param env environment the benchmark ran on.
+ * @param results results of every run, in order.
+ * @param load results of the load phase.
+ */
+void write_json(std::ostream& os, const environment_t& env, const std::vector<result_t>& results,
+                const load_result_t& load = load_result_t());
+
+/**
+ * @brief Write environment and results as CSV in long format.
+ *
+ * Every value is a row with columns phase, section, operation, outcome,
+ * window, metric and value, so results of different runs can be
+ * concatenated and filtered without knowing the set of metrics in advance.
+ * Columns that do not apply to a value are left empty. Results of the load
+ * phase, if any, are in the "load" phase.
+ *
+ * @param os stream to write to.
+ * @param env environment the benchmark ran on.
+ * @param results results of every run, in order.
+ * @param load results of the load phase.
+ */
+void write_csv(std::ostream& os, const environment_t& env, const std::vector<result_t>& results,
+               const load_result_t& load = load_result_t());
+
+} // namespace PiBench
+#endif
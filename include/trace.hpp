@@ -0,0 +1,303 @@
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include "benchmark.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace PiBench
+{
+
+/**
+ * @brief Header of a binary trace file.
+ *
+ * A trace file is this header followed by 'num_records' fixed-size records.
+ * Each record is the operation (1 Byte), the value size (2 Bytes), the scan
+ * length (2 Bytes) and the key ('key_size' Bytes), with integers in host byte
+ * order. Values are not stored, they are generated when replaying.
+ */
+struct trace_header_t
+{
+    /// Identifies the file as a trace ("PIBTRACE").
+    char magic[8];
+
+    /// Version of the format.
+    uint32_t version;
+
+    /// Size in Bytes of every key in the trace (including prefix).
+    uint32_t key_size;
+
+    /// Number of records in the trace.
+    uint64_t num_records;
+};
+static_assert(sizeof(trace_header_t) == 24, "Trace header must not be padded.");
+
+/**
+ * @brief A single request of a trace.
+ *
+ */
+struct trace_request_t
+{
+    operation_t op;
+
+    /// Size of the value written by inserts and updates (0 otherwise).
+    uint32_t value_size;
+
+    /// Number of records read by scans (0 otherwise).
+    uint32_t scan_size;
+
+    /// Pointer to the key, valid while the trace is open.
+    const char* key;
+};
+
+/**
+ * @brief Writes requests to a binary trace file.
+ *
+ * Records can either be appended one at a time, or be encoded by the caller
+ * and written at a given position, so that several threads can fill disjoint
+ * ranges of the same file concurrently.
+ */
+class trace_writer_t
+{
+public:
+    /**
+     * @brief Create (or truncate) a trace file.
+     *
+     * @param path path of the trace file.
+     * @param key_size size in Bytes of every key.
+     * @throw std::runtime_error if the file cannot be created.
+     */
+    trace_writer_t(const std::string& path, uint32_t key_size);
+
+    /**
+     * @brief Close the file, if not closed yet (errors are ignored).
+     *
+     */
+    ~trace_writer_t();
+
+    /// Size in Bytes of every key.
+    uint32_t key_size() const noexcept { return key_size_; }
+
+    /// Size in Bytes of each record.
+    size_t record_size() const noexcept { return RECORD_HEADER + key_size_; }
+
+    /**
+     * @brief Encode a request into 'record_size()' Bytes.
+     *
+     * Value sizes and scan lengths that do not fit the format are clamped.
+     */
+    void encode(char* record, operation_t op, const char* key, uint32_t value_size, uint32_t scan_size) const noexcept;
+
+    /**
+     * @brief Append a request after the last record written.
+     *
+     * Must not be mixed with concurrent calls to write().
+     *
+     * @throw std::runtime_error on I/O error.
+     */
+    void append(operation_t op, const char* key, uint32_t value_size, uint32_t scan_size);
+
+    /**
+     * @brief Write encoded records starting at the given record index.
+     *
+     * Thread safe as long as concurrent calls write disjoint ranges.
+     *
+     * @param index position of the first record.
+     * @param records 'count' encoded records.
+     * @param count
+     * @throw std::runtime_error on I/O error.
+     */
+    void write(uint64_t index, const char* records, uint64_t count);
+
+    /**
+     * @brief Flush pending records, write the header and close the file.
+     *
+     * The trace holds every record up to the highest one written.
+     *
+     * @return uint64_t number of records in the trace.
+     * @throw std::runtime_error on I/O error.
+     */
+    uint64_t close();
+
+    /// Bytes of each record preceding the key.
+    static constexpr size_t RECORD_HEADER = 5;
+
+private:
+    void flush();
+
+    /// Path of the trace file (for error messages).
+    std::string path_;
+
+    /// File descriptor, -1 if closed.
+    int fd_;
+
+    /// Size in Bytes of every key.
+    uint32_t key_size_;
+
+    /// One past the highest record written so far.
+    std::atomic<uint64_t> num_records_;
+
+    /// Records appended but not written yet.
+    std::vector<char> buf_;
+
+    /// Index of the first record in buf_.
+    uint64_t buf_index_;
+};
+
+/**
+ * @brief Read-only view of a binary trace file mapped in memory.
+ *
+ * The file is never read into memory as a whole: pages are faulted in as the
+ * records are accessed, so traces can be larger than the physical memory.
+ */
+class trace_reader_t
+{
+public:
+    /**
+     * @brief Map a trace file.
+     *
+     * @param path path of the trace file.
+     * @throw std::runtime_error if the file cannot be mapped or is not a valid trace.
+     */
+    explicit trace_reader_t(const std::string& path);
+
+    ~trace_reader_t();
+
+    trace_reader_t(const trace_reader_t&) = delete;
+    trace_reader_t& operator=(const trace_reader_t&) = delete;
+
+    /// Number of records in the trace.
+    uint64_t size() const noexcept { return num_records_; }
+
+    /// Size in Bytes of every key in the trace.
+    uint32_t key_size() const noexcept { return key_size_; }
+
+    /// Size in Bytes of each record.
+    size_t record_size() const noexcept { return trace_writer_t::RECORD_HEADER + key_size_; }
+
+    /// Decode the i-th record.
+    trace_request_t get(uint64_t i) const noexcept;
+
+    /// Hint that records in [first, last) will be read soon.
+    void will_need(uint64_t first, uint64_t last) const noexcept;
+
+    /// Hint that records in [first, last) will not be read again.
+    void dont_need(uint64_t first, uint64_t last) const noexcept;
+
+private:
+    /// Apply memory advice to the pages covering records [first, last).
+    void advise(uint64_t first, uint64_t last, int advice) const noexcept;
+
+    /// Beginning of the mapping (i.e., the header).
+    char* data_;
+
+    /// Size of the mapping in Bytes.
+    size_t length_;
+
+    uint32_t key_size_;
+    uint64_t num_records_;
+};
+
+/**
+ * @brief Sequential reader over a range of records of a trace.
+ *
+ * Keeps a window of records ahead of the current position being read in, and
+ * releases the pages that were already consumed.
+ */
+class trace_cursor_t
+{
+public:
+    /**
+     * @brief Construct a cursor over records [first, last).
+     *
+     */
+    trace_cursor_t(const trace_reader_t& trace, uint64_t first, uint64_t last) noexcept;
+
+    /**
+     * @brief Read next request.
+     *
+     * @return false if there are no records left.
+     */
+    bool next(trace_request_t& request) noexcept
+    {
+        if (pos_ == last_)
+            return false;
+        if (pos_ == next_advice_)
+            advance_window();
+        request = trace_.get(pos_++);
+        return true;
+    }
+
+    /// Bytes read ahead of the current position.
+    static constexpr size_t READAHEAD = 8 << 20;
+
+private:
+    void advance_window() noexcept;
+
+    const trace_reader_t& trace_;
+    uint64_t pos_;
+    uint64_t last_;
+
+    /// Records per readahead window.
+    uint64_t window_;
+
+    /// Position at which the next window is requested.
+    uint64_t next_advice_;
+
+    /// First record not released yet.
+    uint64_t released_;
+};
+
+/**
+ * @brief Range of records [first, last) of thread 'tid' when splitting
+ * 'num_records' across 'num_threads' threads in contiguous partitions.
+ *
+ */
+void trace_partition(uint64_t num_records, uint32_t num_threads, uint32_t tid, uint64_t& first, uint64_t& last);
+
+/**
+ * @brief Parse a request from a line of a YCSB text trace.
+ *
+ * Lines look like the output of YCSB's BasicDB, e.g.:
+ *
+ * READ usertable user6284781860667377211 [ <all fields>]
+ * UPDATE usertable user6284781860667377211 [ field3=... ]
+ * INSERT usertable user6284781860667377211 [ field0=... field1=... ]
+ * SCAN usertable user6284781860667377211 75 [ <all fields>]
+ * DELETE usertable user6284781860667377211
+ *
+ * The value size is the total length of the field values. If the key is a
+ * number after a non-numeric prefix (e.g., "user" above), the number is
+ * stored the same way the key generator stores ids. Otherwise, the key is
+ * copied and padded with zeroes.
+ *
+ * @param line line to be parsed.
+ * @param key_size size in Bytes of the keys to be produced.
+ * @param request parsed request, its key points to 'key'.
+ * @param key buffer of 'key_size' Bytes where the key is materialized.
+ * @param encoding byte order of numeric ids in keys.
+ * @return true if the line is a request.
+ * @return false if it is not (e.g., YCSB status messages) or the key does not fit.
+ */
+bool parse_ycsb_request(const std::string& line, uint32_t key_size, trace_request_t& request, char* key,
+                        key_encoding_t encoding = key_encoding_t::NATIVE);
+
+/**
+ * @brief Convert a YCSB text trace to a binary trace.
+ *
+ * @param in stream with the YCSB trace.
+ * @param out trace to append the requests to.
+ * @param skipped number of lines ignored.
+ * @param encoding byte order of numeric ids in keys.
+ * @return uint64_t number of requests imported.
+ * @throw std::runtime_error on I/O error.
+ */
+uint64_t import_ycsb(std::istream& in, trace_writer_t& out, uint64_t& skipped,
+                     key_encoding_t encoding = key_encoding_t::NATIVE);
+
+} // namespace PiBench
+#endif
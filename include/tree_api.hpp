@@ -16,6 +16,7 @@
 #define __TREE_API_HPP__
 
 #include <cstddef>
+#include <new>
 #include <string>
 
 struct tree_options_t
@@ -25,6 +26,10 @@ struct tree_options_t
     std::string pool_path = "";
     size_t pool_size = 0;
     size_t num_threads = 1;
+
+    /// Integer ids in keys are stored most significant Byte first (i.e.,
+    /// memcmp order is numeric order), instead of in host byte order.
+    bool big_endian_keys = false;
 };
 
 class tree_api;
@@ -111,6 +116,143 @@ public:
      * return scanned;
      */
     virtual int scan(const char* key, size_t key_sz, int scan_sz, char*& values_out) = 0;
+
+    /**
+     * @brief Lookup a batch of records.
+     *
+     * Optional: the default implementation calls find() for every key.
+     * Trees that can amortize work across keys (e.g., sorting the batch,
+     * sharing traversals or prefetching) should override it.
+     *
+     * @param[in] num Number of keys in the batch.
+     * @param[in] keys Pointers to the beginning of each key.
+     * @param[in] sz Size of keys in bytes.
+     * @param[out] values_out Buffers to fill with the value of each key.
+     * @param[out] found Whether each key was found.
+     * @return size_t Number of keys found.
+     */
+    virtual size_t multi_find(size_t num, const char* const* keys, size_t sz, char* const* values_out, bool* found)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < num; ++i)
+        {
+            found[i] = find(keys[i], sz, values_out[i]);
+            n += found[i];
+        }
+        return n;
+    }
+
+    /**
+     * @brief Insert a batch of records.
+     *
+     * Optional: the default implementation calls insert() for every record.
+     *
+     * @param[in] num Number of records in the batch.
+     * @param[in] keys Pointers to the beginning of each key.
+     * @param[in] key_sz Size of keys in bytes.
+     * @param[in] values Pointers to the beginning of each value.
+     * @param[in] value_sz Size of values in bytes.
+     * @param[out] inserted Whether each record was inserted.
+     * @return size_t Number of records inserted.
+     */
+    virtual size_t multi_insert(size_t num, const char* const* keys, size_t key_sz,
+                                const char* const* values, size_t value_sz, bool* inserted)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < num; ++i)
+        {
+            inserted[i] = insert(keys[i], key_sz, values[i], value_sz);
+            n += inserted[i];
+        }
+        return n;
+    }
+
+    /**
+     * @brief Load sorted records into the tree.
+     *
+     * Called from a single thread, either once with all records or with
+     * consecutive chunks of them, before any other operation. Keys are
+     * unique and sorted in lexicographic (memcmp) order across all calls.
+     * PiBench only bulk loads big-endian keys (big_endian_keys is set), so
+     * this is also the numeric order of the ids stored in the keys.
+     *
+     * Optional: the default implementation calls insert() for every record.
+     * Trees with a bottom-up build path should override it.
+     *
+     * @param[in] num Number of records.
+     * @param[in] keys Pointers to the beginning of each key.
+     * @param[in] key_sz Size of keys in bytes.
+     * @param[in] values Pointers to the beginning of each value.
+     * @param[in] value_sz Size of values in bytes.
+     * @return size_t Number of records loaded.
+     */
+    virtual size_t bulk_load(size_t num, const char* const* keys, size_t key_sz,
+                             const char* const* values, size_t value_sz)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < num; ++i)
+            n += insert(keys[i], key_sz, values[i], value_sz);
+        return n;
+    }
+
+    /**
+     * @brief Size in Bytes of the state of an interleaved lookup.
+     *
+     * Interleaved lookups let a thread keep several lookups in flight and
+     * switch between them while the memory they need is being fetched
+     * (Asynchronous Memory Access Chaining). A lookup is started with
+     * find_start() and then advanced with find_step() until it completes.
+     *
+     * Optional: by default a lookup completes in a single step that calls
+     * find(), which gives no overlap.
+     *
+     * @return size_t
+     */
+    virtual size_t find_state_size() const { return sizeof(find_state_t); }
+
+    /**
+     * @brief Start an interleaved lookup.
+     *
+     * Should only initialize the state and prefetch the memory needed by
+     * the first step (e.g., the root node), without waiting for it.
+     *
+     * @param[out] state find_state_size() Bytes owned by the lookup until it completes.
+     * @param[in] key Pointer to beginning of key, valid until the lookup completes.
+     * @param[in] key_sz Size of key in bytes.
+     * @param[out] value_out Buffer to fill with value once found.
+     */
+    virtual void find_start(void* state, const char* key, size_t key_sz, char* value_out)
+    {
+        new (state) find_state_t{key, key_sz, value_out};
+    }
+
+    /**
+     * @brief Advance an interleaved lookup.
+     *
+     * Each step should use the memory prefetched by the previous one and end
+     * by prefetching the memory needed by the next (e.g., descend one level
+     * of the tree and prefetch the child node).
+     *
+     * @param[in,out] state state initialized by find_start().
+     * @param[out] found Whether the key was found, once complete.
+     * @return true if the lookup is complete.
+     * @return false if it needs more steps.
+     */
+    virtual bool find_step(void* state, bool& found)
+    {
+        auto s = static_cast<find_state_t*>(state);
+        found = find(s->key, s->key_sz, s->value_out);
+        return true;
+    }
+
+private:
+    /// State of the default interleaved lookup.
+    struct find_state_t
+    {
+        const char* key;
+        size_t key_sz;
+        char* value_out;
+    };
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef __UTILS_HPP__
 #define __UTILS_HPP__
 
+#include <cassert>
 #include <cstdint>
 
 namespace PiBench
@@ -108,6 +109,37 @@ namespace utils
         return A * x;
     }
 
+    /**
+     * @brief Shuffle the integers in range [0, 2^bits) without collisions.
+     *
+     * Balanced Feistel network whose round function takes the high bits of a
+     * multiplicative hash of the right half and a round key. Unlike
+     * discrete_log(), any even number of bits up to 64 is supported.
+     *
+     * @param x integer to be shuffled, must be smaller than 2^bits.
+     * @param bits even number of bits, in range [2, 64].
+     * @param key selects one of the permutations.
+     * @return uint64_t
+     */
+    static uint64_t feistel_permute(uint64_t x, uint32_t bits, uint64_t key = 0x5DEECE66Dull) noexcept
+    {
+        static constexpr uint32_t ROUNDS = 4;
+        assert(bits >= 2 && bits <= 64 && bits % 2 == 0);
+
+        const uint32_t half = bits / 2;
+        const uint64_t mask = (1ULL << half) - 1;
+        uint64_t left = (x >> half) & mask;
+        uint64_t right = x & mask;
+        for (uint32_t i = 0; i < ROUNDS; ++i)
+        {
+            uint64_t f = multiplicative_hash<uint64_t>(right ^ (key + i)) >> (64 - half);
+            uint64_t next = left ^ f;
+            left = right;
+            right = next;
+        }
+        return (left << half) | right;
+    }
+
     /**
      * @brief Verify endianess during runtime.
      *
@@ -1,6 +1,8 @@
 #ifndef __VALUE_GENERATOR_HPP__
 #define __VALUE_GENERATOR_HPP__
 
+#include "xoshiro256pp_engine.hpp"
+
 #include <cstdint>
 #include <random>
 
@@ -34,6 +36,20 @@ public:
         return &VALUE_POOL[pos];
     }
 
+    /**
+     * @brief Returns a pointer to beginning of value of the given size.
+     *
+     * @param size at most VALUE_MAX.
+     * @return const char*
+     */
+    const char* next(uint32_t size)
+    {
+        auto pos = dist_(gen_);
+        if (size > size_)
+            pos %= sizeof(VALUE_POOL) - size;
+        return &VALUE_POOL[pos];
+    }
+
     /**
      * @brief Get size in Bytes of values generated.
      *
@@ -73,7 +89,7 @@ private:
     static thread_local uint32_t seed_;
 
     /// Engine used for generating a random start position in VALUE_POOL.
-    static thread_local std::default_random_engine gen_;
+    static thread_local xoshiro256pp_engine gen_;
 
     /// Distribution used for generating a random start position in VALUE_POOL.
     std::uniform_int_distribution<> dist_;
@@ -0,0 +1,76 @@
+#ifndef __WORKLOAD_FILE_HPP__
+#define __WORKLOAD_FILE_HPP__
+
+#include "benchmark.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace PiBench
+{
+
+/**
+ * @brief A single phase of a multi-phase workload.
+ *
+ */
+struct phase_t
+{
+    /// Name of the phase as given in the workload file.
+    std::string name;
+
+    /// Options used to run the phase.
+    options_t opt;
+};
+
+/**
+ * @brief Parse a workload description consisting of an ordered list of phases.
+ *
+ * The format is INI-like. Each phase starts with its name between brackets,
+ * followed by "key = value" lines. Empty lines and lines starting with '#'
+ * or ';' are ignored. For example:
+ *
+ * [read-heavy]
+ * read_ratio = 0.95
+ * update_ratio = 0.05
+ * distribution = zipfian
+ * skew = 0.99
+ * seconds = 60
+ *
+ * [write-burst]
+ * insert_ratio = 1.0
+ * threads = 16
+ * operations = 10000000
+ *
+ * Every phase starts from the options given in 'base' and overrides the keys
+ * it specifies. The supported keys follow the names of the command line
+ * options: workload, read_ratio, insert_ratio, update_ratio, remove_ratio,
+ * scan_ratio, rmw_ratio, scan_size, scan_length, distribution, skew, hot_set, hot_ops, hot_shift, hot_shift_ms,
+ * hot_step, threads, operations, seconds, sampling_ms,
+ * latency_sampling, rate, arrival, batch_size, interleave, record_trace and replay_trace.
+ *
+ * If a phase sets any of the ratios, the ratios it does not set are zero.
+ * A workload preset sets all ratios, so it must be the first key of its
+ * phase.
+ * Setting 'operations' selects the operation-based mode and 'seconds' the
+ * time-based mode for that phase.
+ *
+ * @param in stream to read the workload description from.
+ * @param base options each phase starts from.
+ * @return std::vector<phase_t> phases in the order they should run.
+ * @throw std::invalid_argument if the description is malformed.
+ */
+std::vector<phase_t> parse_workload(std::istream& in, const options_t& base);
+
+/**
+ * @brief Parse workload description from a file.
+ *
+ * @param path path to the workload file.
+ * @param base options each phase starts from.
+ * @return std::vector<phase_t>
+ * @throw std::invalid_argument if the file cannot be read or is malformed.
+ */
+std::vector<phase_t> parse_workload_file(const std::string& path, const options_t& base);
+
+} // namespace PiBench
+#endif
@@ -1,6 +1,6 @@
 /* Implementation derived from:
- * "Quickly Generating Billion-Record Synthetic Databases", Jim Gray et al,
- * SIGMOD 1994
+ * "Rejection-Inversion to Generate Variates from Monotone Discrete
+ * Distributions", Wolfgang Hörmann and Gerhard Derflinger, ACM TOMACS 1996
  *
  * The zipfian_int_distribution class is intended to be compatible with other
  * distributions introduced in #include <random> by the C++11 standard.
@@ -17,21 +17,14 @@
  */
 
 /*
- * IMPORTANT: constructing the distribution object requires calculating the zeta
- * value which becomes prohibetively expensive for very large ranges. As an
- * alternative for such cases, the user can pass the pre-calculated values and
- * avoid the calculation every time.
- *
- * Usage example:
- * #include <random>
- * #include "zipfian_int_distribution.h"
- * int main()
- * {
- *   std::default_random_engine generator;
- *   zipfian_int_distribution<int>::param_type p(1, 1e6, 0.99, 27.000);
- *   zipfian_int_distribution<int> distribution(p);
- *   int i = distribution(generator);
- * }
+ * Rank k of the range (k = 1 is the lower bound) is drawn with probability
+ * proportional to 1 / k^theta, for any theta >= 0. Unlike the method of Gray
+ * et al., which needs the zeta value of the whole range (an O(N) sum),
+ * rejection-inversion samples a continuous hat function by inversion and
+ * rejects the few samples that fall outside the histogram of the
+ * distribution. Constructing the distribution takes constant time, and a
+ * sample takes a log() and an exp() on average, with less than one rejection
+ * in ten (fewer the larger the range).
  */
 
 #include <cassert>
@@ -53,17 +46,13 @@ public:
         typedef zipfian_int_distribution<_IntType> distribution_type;
 
         explicit param_type(_IntType __a = 0, _IntType __b = std::numeric_limits<_IntType>::max(), double __theta = 0.99)
-            : _M_a(__a), _M_b(__b), _M_theta(__theta),
-              _M_zeta(zeta(_M_b - _M_a + 1, __theta)), _M_zeta2theta(zeta(2, __theta))
-        {
-            assert(_M_a <= _M_b && _M_theta > 0.0 && _M_theta < 1.0);
-        }
-
-        explicit param_type(_IntType __a, _IntType __b, double __theta, double __zeta)
-            : _M_a(__a), _M_b(__b), _M_theta(__theta), _M_zeta(__zeta),
-              _M_zeta2theta(zeta(2, __theta))
+            : _M_a(__a), _M_b(__b), _M_theta(__theta)
         {
-            __glibcxx_assert(_M_a <= _M_b && _M_theta > 0.0 && _M_theta < 1.0);
+            assert(_M_a <= _M_b && _M_theta >= 0.0);
+            _M_n = static_cast<double>(_M_b - _M_a) + 1.0;
+            _M_h_integral_x1 = h_integral(1.5) - 1.0;
+            _M_h_integral_n = h_integral(_M_n + 0.5);
+            _M_s = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
         }
 
         result_type a() const { return _M_a; }
@@ -72,38 +61,77 @@ public:
 
         double theta() const { return _M_theta; }
 
-        double zeta() const { return _M_zeta; }
-
-        double zeta2theta() const { return _M_zeta2theta; }
-
         friend bool operator==(const param_type& __p1, const param_type& __p2)
         {
             return __p1._M_a == __p2._M_a
                 && __p1._M_b == __p2._M_b
-                && __p1._M_theta == __p2._M_theta
-                && __p1._M_zeta == __p2._M_zeta
-                && __p1._M_zeta2theta == __p2._M_zeta2theta;
+                && __p1._M_theta == __p2._M_theta;
         }
 
     private:
+        friend class zipfian_int_distribution<_IntType>;
+
         _IntType _M_a;
         _IntType _M_b;
         double _M_theta;
-        double _M_zeta;
-        double _M_zeta2theta;
+
+        /// Number of values in the range.
+        double _M_n;
+
+        /// Bounds of the hat function's integral sampled by inversion.
+        double _M_h_integral_x1;
+        double _M_h_integral_n;
+
+        /// Samples this close to their rank are accepted right away.
+        double _M_s;
 
         /**
-         * @brief Calculates zeta.
-         *
-         * @param __n [IN]  The size of the domain.
-         * @param __theta [IN]  The skew factor of the distribution.
+         * @brief Hat function, 1 / x^theta.
          */
-        double zeta(unsigned long __n, double __theta)
+        double h(double __x) const
         {
-            double ans = 0.0;
-            for (unsigned long i=1; i<=__n; ++i)
-                ans += std::pow(1.0 / i, __theta);
-            return ans;
+            return std::exp(-_M_theta * std::log(__x));
+        }
+
+        /**
+         * @brief Integral of the hat function, (x^(1-theta) - 1) / (1-theta)
+         *        (or log(x) when theta is 1).
+         */
+        double h_integral(double __x) const
+        {
+            double log_x = std::log(__x);
+            return helper2((1.0 - _M_theta) * log_x) * log_x;
+        }
+
+        /**
+         * @brief Inverse of h_integral().
+         */
+        double h_integral_inverse(double __x) const
+        {
+            double t = __x * (1.0 - _M_theta);
+            if (t < -1.0)
+                t = -1.0; // Limit of the domain, only hit due to rounding errors
+            return std::exp(helper1(t) * __x);
+        }
+
+        /**
+         * @brief log(1+x)/x, accurate around x = 0.
+         */
+        static double helper1(double __x)
+        {
+            if (std::abs(__x) > 1e-8)
+                return std::log1p(__x) / __x;
+            return 1.0 - __x * (0.5 - __x * (1.0 / 3.0 - 0.25 * __x));
+        }
+
+        /**
+         * @brief (exp(x)-1)/x, accurate around x = 0.
+         */
+        static double helper2(double __x)
+        {
+            if (std::abs(__x) > 1e-8)
+                return std::expm1(__x) / __x;
+            return 1.0 + __x * 0.5 * (1.0 + __x * (1.0 / 3.0) * (1.0 + 0.25 * __x));
         }
     };
 
@@ -170,18 +198,23 @@ public:
     template <typename _UniformRandomNumberGenerator>
     result_type operator()(_UniformRandomNumberGenerator& __urng, const param_type& __p)
     {
-        double alpha = 1 / (1 - __p.theta());
-        double eta = (1 - std::pow(2.0 / (__p.b() - __p.a() + 1), 1 - __p.theta())) / (1 - __p.zeta2theta() / __p.zeta());
-
-        double u = std::generate_canonical<double, std::numeric_limits<double>::digits, _UniformRandomNumberGenerator>(__urng);
-
-        double uz = u * __p.zeta();
-        if (uz < 1.0)
-            return __p.a();
-        if (uz < 1.0 + std::pow(0.5, __p.theta()))
-            return __p.a() + 1;
-
-        return __p.a() + ((__p.b() - __p.a() + 1) * std::pow(eta * u - eta + 1, alpha));
+        while (true)
+        {
+            double u = std::generate_canonical<double, std::numeric_limits<double>::digits, _UniformRandomNumberGenerator>(__urng);
+
+            // Invert the integral of the hat function, then round to the rank
+            u = __p._M_h_integral_n + u * (__p._M_h_integral_x1 - __p._M_h_integral_n);
+            double x = __p.h_integral_inverse(u);
+            double k = std::floor(x + 0.5);
+            if (k < 1.0)
+                k = 1.0;
+            else if (k > __p._M_n)
+                k = __p._M_n;
+
+            // Accept if under the histogram of the distribution
+            if (k - x <= __p._M_s || u >= __p.h_integral(k + 0.5) - __p.h(k))
+                return __p.a() + static_cast<result_type>(k - 1.0);
+        }
     }
 
     /**
@@ -195,4 +228,4 @@ public:
 
 private:
     param_type _M_param;
-};
\ No newline at end of file
+};
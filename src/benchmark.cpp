@@ -1,21 +1,31 @@
 #include "benchmark.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <omp.h>
 #include <functional> // std::bind
 #include <cmath>      // std::ceil
+#include <cstddef>    // std::max_align_t
+#include <cstring>    // memcpy
 #include <ctime>
 #include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>    // std::accumulate
+#include <sstream>
 #include <regex>            // std::regex_replace
 #include <sys/utsname.h>    // uname
+#include <unistd.h>         // sysconf
 
 namespace PiBench
 {
 
-void print_environment()
+environment_t get_environment()
 {
     std::time_t now = std::time(nullptr);
     uint64_t num_cpus = 0;
@@ -69,19 +79,311 @@ void print_environment()
         kernel_version = std::string(uname_buf.sysname) + " " + std::string(uname_buf.release);
     }
 
+    environment_t env;
+    env.time = std::asctime(std::localtime(&now));
+    env.time.pop_back(); // Trailing new line
+    env.num_cpus = num_cpus;
+    env.cpu_type = cpu_type;
+    env.cache_size = cache_size;
+    env.kernel = kernel_version;
+    return env;
+}
+
+uint64_t resident_memory()
+{
+    // Second field is the number of resident pages
+    std::ifstream statm("/proc/self/statm", std::ifstream::in);
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void print_environment(const environment_t& env)
+{
     std::cout << "Environment:" << "\n"
-              << "\tTime: " << std::asctime(std::localtime(&now))
-              << "\tCPU: " << num_cpus << " * " << cpu_type << "\n"
-              << "\tCPU Cache: " << cache_size << "\n"
-              << "\tKernel: " << kernel_version << std::endl;
+              << "\tTime: " << env.time << "\n"
+              << "\tCPU: " << env.num_cpus << " * " << env.cpu_type << "\n"
+              << "\tCPU Cache: " << env.cache_size << "\n"
+              << "\tKernel: " << env.kernel << std::endl;
+}
+
+/**
+ * @brief Warn about sampling windows whose latencies were skipped because
+ * draining the previous ones took longer than a window.
+ */
+static void warn_late_windows(size_t count, double sampling_ms)
+{
+    if (count > 0)
+    {
+        std::cout << "Warning: latencies of " << count << " sampling windows skipped, draining windows took longer than "
+                  << sampling_ms << " ms (use a longer --sampling_ms or fewer threads)." << std::endl;
+    }
+}
+
+/**
+ * @brief Merge and reset the per-thread histograms of the given window.
+ *
+ * @param skip reset the histograms without merging them.
+ * @return percentiles of the window in timer ticks, per operation type
+ *         (empty if skipped).
+ */
+static std::array<window_percentiles_t, NUM_OPERATIONS> drain_window_latencies(
+    std::vector<window_latency_stats_t>& windows, uint64_t w, bool skip = false)
+{
+    auto slot = w % window_latency_stats_t::SLOTS;
+    std::array<window_percentiles_t, NUM_OPERATIONS> summary;
+    window_histogram_t merged;
+    for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+    {
+        merged.reset();
+        for (auto& l : windows)
+        {
+            if (!skip)
+                merged.merge(l.ops[slot][op]);
+            l.ops[slot][op].reset();
+        }
+        summary[op].count = merged.count();
+        summary[op].p50 = merged.percentile(0.5);
+        summary[op].p99 = merged.percentile(0.99);
+        summary[op].p999 = merged.percentile(0.999);
+        summary[op].max = merged.max();
+    }
+    return summary;
+}
+
+uint64_t insert_frontier(uint64_t first_insert_id, const std::vector<thread_stats_t>& stats) noexcept
+{
+    uint64_t min_done = std::numeric_limits<uint64_t>::max();
+    for (const auto& s : stats)
+        min_done = std::min(min_done, s.completed(operation_t::INSERT));
+    if (stats.empty())
+        return first_insert_id - 1;
+
+    // Threads before the first one not ahead of the slowest filled the next ids
+    uint64_t frontier = first_insert_id - 1 + min_done * stats.size();
+    for (size_t t = 0; t < stats.size() && stats[t].completed(operation_t::INSERT) > min_done; ++t)
+        ++frontier;
+    return frontier;
+}
+
+uint64_t stream_seed(uint32_t rnd_seed, uint32_t tid, random_stream_t stream) noexcept
+{
+    if (stream == random_stream_t::KEY)
+        return static_cast<uint32_t>(rnd_seed * (tid + 1));
+
+    // splitmix64 over the seed, then the thread, then the stream
+    uint64_t z = rnd_seed;
+    for (uint64_t x : {uint64_t(tid), uint64_t(stream)})
+    {
+        z += 0x9E3779B97F4A7C15ull + x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+    }
+    return z;
+}
+
+uint64_t latest_id(uint64_t rank, uint64_t newest) noexcept
+{
+    if (newest == 0)
+        return rank;
+    return rank <= newest ? newest + 1 - rank : 1 + (rank - 1) % newest;
+}
+
+/**
+ * @brief Throughput of the sampling windows around each move of the hot set.
+ *
+ * @param samples operation counters of each window.
+ * @param windows first window with the new hot set, of each move.
+ * @param sampling_ms length of the windows.
+ */
+static std::vector<hot_shift_result_t> summarize_hot_shifts(
+    const std::vector<stats_t>& samples, const std::vector<uint64_t>& windows, double sampling_ms)
+{
+    auto throughput = [&](uint64_t w) { return samples[w].operation_count * 1000.0 / sampling_ms; };
+
+    std::vector<hot_shift_result_t> shifts;
+    for (size_t i = 0; i < windows.size(); ++i)
+    {
+        // Moves after the last window were not measured
+        uint64_t w = windows[i];
+        if (w == 0 || w >= samples.size())
+            continue;
+        uint64_t end = i + 1 < windows.size() ? std::min<uint64_t>(windows[i + 1], samples.size()) : samples.size();
+
+        hot_shift_result_t shift;
+        shift.window = w;
+        shift.before = throughput(w - 1);
+        for (uint64_t a = w; a < end; ++a)
+        {
+            if (a - w < hot_shift_result_t::WINDOWS)
+                shift.after.push_back(throughput(a));
+            if (shift.recovery_ms < 0.0 && throughput(a) >= 0.9 * shift.before)
+                shift.recovery_ms = (a - w + 1) * sampling_ms;
+        }
+        shifts.push_back(std::move(shift));
+    }
+    return shifts;
+}
+
+bool parse_distribution(std::string name, distribution_t& dist)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("uniform") == 0)
+        dist = distribution_t::UNIFORM;
+    else if (name.compare("selfsimilar") == 0)
+        dist = distribution_t::SELFSIMILAR;
+    else if (name.compare("zipfian") == 0)
+        dist = distribution_t::ZIPFIAN;
+    else if (name.compare("latest") == 0)
+        dist = distribution_t::LATEST;
+    else if (name.compare("scrambled_zipfian") == 0)
+        dist = distribution_t::SCRAMBLED_ZIPFIAN;
+    else if (name.compare("clustered_zipfian") == 0)
+        dist = distribution_t::CLUSTERED_ZIPFIAN;
+    else if (name.compare("hotspot") == 0)
+        dist = distribution_t::HOTSPOT;
+    else
+        return false;
+    return true;
+}
+
+bool parse_hot_shift(std::string name, hot_shift_t& shift)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("none") == 0)
+        shift = hot_shift_t::NONE;
+    else if (name.compare("slide") == 0)
+        shift = hot_shift_t::SLIDE;
+    else if (name.compare("jump") == 0)
+        shift = hot_shift_t::JUMP;
+    else
+        return false;
+    return true;
+}
+
+bool parse_arrival(std::string name, arrival_t& arrival)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("constant") == 0)
+        arrival = arrival_t::CONSTANT;
+    else if (name.compare("poisson") == 0)
+        arrival = arrival_t::POISSON;
+    else
+        return false;
+    return true;
+}
+
+bool parse_key_order(std::string name, key_order_t& order)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("hashed") == 0)
+        order = key_order_t::HASHED;
+    else if (name.compare("sequential") == 0)
+        order = key_order_t::SEQUENTIAL;
+    else if (name.compare("reverse") == 0)
+        order = key_order_t::REVERSE;
+    else if (name.compare("ksorted") == 0)
+        order = key_order_t::KSORTED;
+    else if (name.compare("monotonic") == 0)
+        order = key_order_t::MONOTONIC;
+    else
+        return false;
+    return true;
+}
+
+bool parse_key_encoding(std::string name, key_encoding_t& encoding)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("native") == 0)
+        encoding = key_encoding_t::NATIVE;
+    else if (name.compare("bigendian") == 0)
+        encoding = key_encoding_t::BIGENDIAN;
+    else
+        return false;
+    return true;
+}
+
+bool parse_load_mode(std::string name, load_mode_t& mode)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("insert") == 0)
+        mode = load_mode_t::INSERT;
+    else if (name.compare("bulk") == 0)
+        mode = load_mode_t::BULK;
+    else
+        return false;
+    return true;
+}
+
+bool parse_scan_length(std::string name, scan_length_t& length)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("constant") == 0)
+        length = scan_length_t::CONSTANT;
+    else if (name.compare("uniform") == 0)
+        length = scan_length_t::UNIFORM;
+    else
+        return false;
+    return true;
+}
+
+bool apply_workload_preset(std::string name, options_t& opt)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.size() != 6 || name.compare(0, 5, "ycsb-") != 0 || name[5] < 'a' || name[5] > 'f')
+        return false;
+
+    // Settings shared by all core workloads
+    opt.read_ratio = opt.insert_ratio = opt.update_ratio = opt.remove_ratio = opt.scan_ratio = opt.rmw_ratio = 0.0;
+    opt.key_distribution = distribution_t::ZIPFIAN;
+    opt.key_skew = 0.99;
+    opt.value_size = 1000;
+    opt.scan_size = 100;
+    opt.scan_length = scan_length_t::UNIFORM;
+
+    switch (name[5])
+    {
+    case 'a': // Update heavy
+        opt.read_ratio = 0.5;
+        opt.update_ratio = 0.5;
+        break;
+    case 'b': // Read mostly
+        opt.read_ratio = 0.95;
+        opt.update_ratio = 0.05;
+        break;
+    case 'c': // Read only
+        opt.read_ratio = 1.0;
+        break;
+    case 'd': // Read latest
+        opt.read_ratio = 0.95;
+        opt.insert_ratio = 0.05;
+        opt.key_distribution = distribution_t::LATEST;
+        break;
+    case 'e': // Short ranges
+        opt.scan_ratio = 0.95;
+        opt.insert_ratio = 0.05;
+        break;
+    case 'f': // Read-modify-write
+        opt.read_ratio = 0.5;
+        opt.rmw_ratio = 0.5;
+        break;
+    }
+    return true;
 }
 
 benchmark_t::benchmark_t(tree_api* tree, const options_t& opt) noexcept
     : tree_(tree),
       opt_(opt),
-      op_generator_(opt.read_ratio, opt.insert_ratio, opt.update_ratio, opt.remove_ratio, opt.scan_ratio),
+      op_generator_(opt.read_ratio, opt.insert_ratio, opt.update_ratio, opt.remove_ratio, opt.scan_ratio, opt.rmw_ratio),
+      timer_(opt.latency_timer),
+      next_insert_id_(opt.num_records + 1),
+      key_streams_(opt.num_threads),
       value_generator_(opt.value_size),
-      pcm_(nullptr)
+      pcm_(nullptr),
+      topology_(read_topology())
 {
     if (opt.enable_pcm)
     {
@@ -97,7 +399,16 @@ benchmark_t::benchmark_t(tree_api* tree, const options_t& opt) noexcept
         }
     }
 
-    size_t key_space_sz = opt_.num_records + (opt_.num_ops * opt_.insert_ratio);
+    configure(opt_);
+}
+
+void benchmark_t::configure(const options_t& opt)
+{
+    opt_ = opt;
+    op_generator_ = operation_generator_t(opt_.read_ratio, opt_.insert_ratio, opt_.update_ratio, opt_.remove_ratio, opt_.scan_ratio, opt_.rmw_ratio);
+
+    // Key space covers records loaded or inserted so far plus the inserts expected in this run.
+    size_t key_space_sz = (next_insert_id_ - 1) + (opt_.num_ops * opt_.insert_ratio);
     switch (opt_.key_distribution)
     {
     case distribution_t::UNIFORM:
@@ -109,13 +420,57 @@ benchmark_t::benchmark_t(tree_api* tree, const options_t& opt) noexcept
         break;
 
     case distribution_t::ZIPFIAN:
+    case distribution_t::LATEST: // Ids are ranks, counted back from the newest record
         key_generator_ = std::make_unique<zipfian_key_generator_t>(key_space_sz, opt_.key_size, opt_.key_prefix, opt_.key_skew);
         break;
 
+    case distribution_t::SCRAMBLED_ZIPFIAN:
+        key_generator_ = std::make_unique<scrambled_zipfian_key_generator_t>(key_space_sz, opt_.key_size, opt_.key_prefix, opt_.key_skew);
+        break;
+
+    case distribution_t::CLUSTERED_ZIPFIAN:
+        key_generator_ = std::make_unique<clustered_zipfian_key_generator_t>(key_space_sz, opt_.key_size, opt_.key_prefix, opt_.key_skew);
+        break;
+
+    case distribution_t::HOTSPOT:
+        key_generator_ = std::make_unique<hotspot_key_generator_t>(key_space_sz, opt_.key_size, opt_.key_prefix, opt_.hot_set, opt_.hot_ops);
+        break;
+
     default:
         std::cout << "Error: unknown distribution!" << std::endl;
         exit(0);
     }
+    key_generator_->set_order(opt_.key_order, opt_.key_displacement, key_streams_);
+    key_generator_->set_encoding(opt_.key_encoding);
+}
+
+std::vector<uint32_t> benchmark_t::placement(uint32_t num_threads) const
+{
+    if (opt_.affinity == affinity_t::NONE)
+        return {};
+    return place_threads(topology_, opt_.affinity, num_threads, opt_.cpus);
+}
+
+const cpu_t* benchmark_t::cpu_info(int cpu) const
+{
+    for (auto& c : topology_)
+        if (static_cast<int>(c.id) == cpu)
+            return &c;
+    return nullptr;
+}
+
+void benchmark_t::set_mempolicy(mempolicy_t policy) const
+{
+    // Leave threads alone unless memory placement was requested at all
+    if (opt_.load_mempolicy == mempolicy_t::DEFAULT && opt_.run_mempolicy == mempolicy_t::DEFAULT)
+        return;
+
+    auto nodes = opt_.mempolicy_nodes.empty() ? numa_nodes(topology_) : opt_.mempolicy_nodes;
+    if (!apply_mempolicy(policy, nodes))
+    {
+        #pragma omp critical
+        std::cout << "WARNING: could not set memory policy " << policy << std::endl;
+    }
 }
 
 benchmark_t::~benchmark_t()
@@ -124,101 +479,517 @@ benchmark_t::~benchmark_t()
         pcm_->cleanup();
 }
 
-void benchmark_t::load() noexcept
+void benchmark_t::sort_records(const std::vector<uint32_t>& cpus, std::vector<char>& keys,
+                               std::vector<const char*>& sorted)
+{
+    const size_t key_size = key_generator_->size();
+    const uint64_t num_records = opt_.num_records;
+    keys.resize(num_records * key_size);
+    sorted.resize(num_records);
+
+    auto less = [key_size](const char* a, const char* b) { return memcmp(a, b, key_size) < 0; };
+
+    #pragma omp parallel num_threads(opt_.num_threads)
+    {
+        if (!cpus.empty())
+            pin_thread(cpus[omp_get_thread_num()]);
+        set_mempolicy(opt_.load_mempolicy);
+
+        // Generate keys in sequence, ids are in the range [1, num_records]
+        const uint64_t batch = key_generator_t::BATCH_SIZE;
+        #pragma omp for schedule(static)
+        for (uint64_t first = 0; first < num_records; first += batch)
+        {
+            uint64_t ids[batch];
+            uint64_t count = std::min(batch, num_records - first);
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                ids[i] = first + i + 1;
+                sorted[first + i] = &keys[(first + i) * key_size];
+            }
+            key_generator_->hash_ids(ids, count, &keys[first * key_size]);
+        }
+
+        // Every thread sorts a contiguous run, then pairs of adjacent runs
+        // are merged until a single run is left.
+        uint64_t tid = omp_get_thread_num();
+        uint64_t num_runs = omp_get_num_threads();
+        auto run_begin = [&](uint64_t run) { return sorted.begin() + num_records * std::min(run, num_runs) / num_runs; };
+
+        std::sort(run_begin(tid), run_begin(tid + 1), less);
+        for (uint64_t width = 1; width < num_runs; width *= 2)
+        {
+            #pragma omp barrier
+            if (tid % (2 * width) == 0 && tid + width < num_runs)
+                std::inplace_merge(run_begin(tid), run_begin(tid + width), run_begin(tid + 2 * width), less);
+        }
+    }
+}
+
+load_result_t benchmark_t::load() noexcept
 {
+    load_result_t result;
+    result.mode = opt_.load_mode;
+    result.records = opt_.num_records;
+    result.sampling_ms = opt_.sampling_ms;
+
     if(opt_.skip_load)
     {
         std::cout << "Load skipped." << std::endl;
-        key_generator_->current_id_ = opt_.num_records + 1;
-        return;
+        return result;
     }
 
     std::cout << "Loading started." << std::endl;
+    auto cpus = placement(opt_.num_threads);
+    int monitor_cpu = cpus.empty() ? -1 : pick_monitor_cpu(topology_, cpus);
+    auto memory_before = resident_memory();
     stopwatch_t sw;
-    sw.start();
 
+    // Bulk loads generate and sort all records before loading starts
+    std::vector<char> keys;
+    std::vector<const char*> sorted;
+    if (opt_.load_mode == load_mode_t::BULK)
+    {
+        sw.start();
+        sort_records(cpus, keys, sorted);
+        result.sort_ms = sw.elapsed<std::chrono::milliseconds>();
+        std::cout << "Records generated and sorted in " << result.sort_ms << " milliseconds" << std::endl;
+    }
+
+    // Records loaded by each thread, sampled by the monitor thread as
+    // during runs, and insert latencies of each thread.
+    std::vector<thread_stats_t> local_stats(opt_.num_threads);
+    std::vector<histogram_t> local_latencies(opt_.latency_sampling > 0.0 ? opt_.num_threads : 0);
+    std::vector<window_latency_stats_t> local_windows(opt_.latency_sampling > 0.0 ? opt_.num_threads : 0);
+    std::vector<stats_t> global_stats;
+    std::vector<std::array<window_percentiles_t, NUM_OPERATIONS>> window_latencies;
+    std::atomic<uint64_t> window(0);
+    std::vector<uint64_t> late_windows; // Stretched by a late drain, skipped
+    std::atomic<bool> started(false);
+    std::atomic<bool> finished(false);
+    uint64_t overhead = opt_.subtract_timer_overhead ? timer_.overhead() : 0;
+    double elapsed = 0.0;
+
+    // Threads insert contiguous ranges of ids, unless keys are ordered. Then
+    // ids are dealt round-robin, so records are inserted in key order overall
+    // (and each thread gets its own stream of MONOTONIC keys).
+    uint64_t load_chunk = opt_.key_order == key_order_t::HASHED
+                          ? std::max<uint64_t>(1, (opt_.num_records + opt_.num_threads - 1) / opt_.num_threads)
+                          : 1;
+
+    omp_set_nested(true);
+    #pragma omp parallel sections num_threads(2)
     {
-        #pragma omp parallel num_threads(opt_.num_threads)
+        #pragma omp section // Monitor thread
         {
-            // Initialize insert id for each thread
-            key_generator_->current_id_ = opt_.num_records / opt_.num_threads * omp_get_thread_num();
+            if (monitor_cpu >= 0)
+                pin_thread(monitor_cpu);
 
-            #pragma omp for schedule(static)
-            for (uint64_t i = 0; i < opt_.num_records; ++i)
+            while (!started.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+            using clock = std::chrono::steady_clock;
+            auto sampling_window = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double, std::milli>(opt_.sampling_ms));
+            auto next_sample = clock::now();
+            while (!finished.load(std::memory_order_acquire))
             {
-                // Generate key in sequence
-                auto key_ptr = key_generator_->next(true);
+                next_sample += sampling_window;
+                std::this_thread::sleep_until(next_sample);
+                stats_t s;
+                for (auto& l : local_stats)
+                    s += l.snapshot();
+                global_stats.push_back(std::move(s));
+
+                if (opt_.latency_sampling > 0.0)
+                {
+                    auto w = window.load(std::memory_order_relaxed);
+                    window.store(w + 1, std::memory_order_relaxed);
+                    if (w > 0)
+                    {
+                        bool skip = std::binary_search(late_windows.begin(), late_windows.end(), w - 1);
+                        window_latencies.push_back(drain_window_latencies(local_windows, w - 1, skip));
+                    }
+                    if (clock::now() > next_sample + sampling_window)
+                        late_windows.push_back(w + 1);
+                }
+            }
+        }
+
+        #pragma omp section // Loading threads
+        {
+            if (opt_.load_mode == load_mode_t::BULK)
+            {
+                sw.start();
+                started.store(true, std::memory_order_release);
+
+                // Hand records over in order, one chunk at a time
+                uint64_t chunk = opt_.load_chunk > 0 ? std::min(opt_.load_chunk, opt_.num_records) : opt_.num_records;
+                std::vector<const char*> values(chunk);
+                for (uint64_t i = 0; i < opt_.num_records; i += chunk)
+                {
+                    auto n = std::min(chunk, opt_.num_records - i);
+                    for (uint64_t j = 0; j < n; ++j)
+                        values[j] = value_generator_.next();
+                    auto loaded = tree_->bulk_load(n, &sorted[i], key_generator_->size(), values.data(), opt_.value_size);
+                    for (uint64_t j = 0; j < n; ++j)
+                        local_stats[0].record(operation_t::INSERT, j < loaded);
+                }
+                elapsed = sw.elapsed<std::chrono::milliseconds>();
+                finished.store(true, std::memory_order_release);
+            }
+            else
+            {
+                #pragma omp parallel num_threads(opt_.num_threads)
+                {
+                    auto tid = omp_get_thread_num();
+                    if (!cpus.empty())
+                        pin_thread(cpus[tid]);
+                    set_mempolicy(opt_.load_mempolicy);
+
+                    auto random_bool = std::bind(std::bernoulli_distribution(opt_.latency_sampling), std::knuth_b());
+
+                    #pragma omp barrier
+
+                    #pragma omp single nowait
+                    {
+                        sw.start();
+                        started.store(true, std::memory_order_release);
+                    }
+
+                    #pragma omp for schedule(static, load_chunk)
+                    for (uint64_t i = 0; i < opt_.num_records; ++i)
+                    {
+                        // Generate key in sequence, ids are in the range [1, num_records]
+                        auto key_ptr = key_generator_->hash_id(i + 1);
+
+                        // Generate random value
+                        auto value_ptr = value_generator_.next();
+
+                        bool measure_latency = random_bool();
+                        uint64_t start = measure_latency ? timer_.start() : 0;
+
+                        auto r = tree_->insert(key_ptr, key_generator_->size(), value_ptr, opt_.value_size);
 
-                // Generate random value
-                auto value_ptr = value_generator_.next();
+                        if (measure_latency)
+                        {
+                            auto ticks = timer_.stop() - start;
+                            auto latency = ticks > overhead ? ticks - overhead : 0;
+                            local_latencies[tid].record(latency);
+                            auto w = window.load(std::memory_order_relaxed) % window_latency_stats_t::SLOTS;
+                            local_windows[tid].ops[w][static_cast<size_t>(operation_t::INSERT)].record(latency);
+                        }
+                        local_stats[tid].record(operation_t::INSERT, r);
+                    }
 
-                auto r = tree_->insert(key_ptr, key_generator_->size(), value_ptr, opt_.value_size);
-                assert(r);
+                    #pragma omp single nowait
+                    {
+                        elapsed = sw.elapsed<std::chrono::milliseconds>();
+                        finished.store(true, std::memory_order_release);
+                    }
+                }
             }
         }
+    }
+    omp_set_nested(false);
 
+    if (opt_.latency_sampling > 0.0 && !global_stats.empty())
+    {
+        uint64_t w = global_stats.size() - 1;
+        bool skip = std::binary_search(late_windows.begin(), late_windows.end(), w);
+        window_latencies.push_back(drain_window_latencies(local_windows, w, skip));
+    }
+    warn_late_windows(std::lower_bound(late_windows.begin(), late_windows.end(), global_stats.size()) - late_windows.begin(),
+                      opt_.sampling_ms);
+
+    // Buffers used to sort records are not part of the footprint
+    keys = std::vector<char>();
+    sorted = std::vector<const char*>();
+    auto memory_after = resident_memory();
+
+    result.loaded = true;
+    result.elapsed_ms = elapsed;
+    for (auto& s : local_stats)
+        result.inserted += s.snapshot().succeeded[static_cast<size_t>(operation_t::INSERT)];
+    if (memory_after > 0)
+    {
+        result.memory_footprint = static_cast<int64_t>(memory_after) - static_cast<int64_t>(memory_before);
+        result.resident_memory = memory_after;
     }
 
-    auto elapsed = sw.elapsed<std::chrono::milliseconds>();
+    uint64_t previous = 0;
+    for (auto& s : global_stats)
+    {
+        result.samples.push_back(s.operation_count - previous);
+        previous = s.operation_count;
+    }
 
-    std::cout << "Loading finished in " << elapsed << " milliseconds" << std::endl;
+    if (opt_.latency_sampling > 0.0 && opt_.load_mode == load_mode_t::INSERT)
+    {
+        auto all = std::make_unique<histogram_t>();
+        for (auto& l : local_latencies)
+            all->merge(l);
+        result.has_latency = true;
+        result.latency = summarize(*all);
+
+        auto ns = [&](uint64_t ticks) { return static_cast<uint64_t>(std::llround(timer_.to_ns(ticks))); };
+        for (auto& w : window_latencies)
+        {
+            auto l = w[static_cast<size_t>(operation_t::INSERT)];
+            l.p50 = ns(l.p50);
+            l.p99 = ns(l.p99);
+            l.p999 = ns(l.p999);
+            l.max = ns(l.max);
+            result.sample_latencies.push_back(l);
+        }
+    }
 
-    // Verify all keys can be found
+    // Look up every record, counting the ones that cannot be found
+    if (opt_.load_verify)
     {
-        #pragma omp parallel num_threads(opt_.num_threads)
+        sw.start();
+        uint64_t missing = 0;
+        #pragma omp parallel num_threads(opt_.num_threads) reduction(+:missing)
         {
-            // Initialize insert id for each thread
-            auto id = opt_.num_records / opt_.num_threads * omp_get_thread_num();
+            if (!cpus.empty())
+                pin_thread(cpus[omp_get_thread_num()]);
 
             #pragma omp for schedule(static)
             for (uint64_t i = 0; i < opt_.num_records; ++i)
             {
                 // Generate key in sequence
-                auto key_ptr = key_generator_->hash_id(id++);
+                auto key_ptr = key_generator_->hash_id(i + 1);
 
                 static thread_local char value_out[value_generator_t::VALUE_MAX];
-                bool found = tree_->find(key_ptr, key_generator_->size(), value_out);
-                if (!found) {
-                    exit(1);
-                }
+                if (!tree_->find(key_ptr, key_generator_->size(), value_out))
+                    ++missing;
             }
         }
+        result.verified = true;
+        result.verify_ms = sw.elapsed<std::chrono::milliseconds>();
+        result.missing = missing;
+    }
+
+    print_load_result(result);
+    return result;
+}
+
+void benchmark_t::print_load_result(const load_result_t& result) const
+{
+    std::cout << "Loading finished in " << result.elapsed_ms << " milliseconds ("
+              << result.records / (result.elapsed_ms / 1000) << " records/s)" << std::endl;
+    if (result.inserted != result.records)
+        std::cout << "WARNING: " << result.records - result.inserted << " of " << result.records << " records were not inserted" << std::endl;
+    if (result.resident_memory > 0)
+    {
+        std::cout << "Memory footprint: " << result.memory_footprint / double(1 << 20)
+                  << " MB loaded (" << result.resident_memory / double(1 << 20) << " MB resident)" << std::endl;
+    }
+
+    if (result.has_latency)
+    {
+        const auto& l = result.latency;
+        std::cout << "Load latency (ns): " << l.count << " inserts sampled, mean " << l.mean
+                  << ", min " << l.min << ", 50% " << l.p50 << ", 90% " << l.p90 << ", 99% " << l.p99
+                  << ", 99.9% " << l.p999 << ", 99.99% " << l.p9999 << ", max " << l.max << '\n';
+    }
+
+    // Throughput of every window shows when the tree slows down as it grows
+    // (e.g., node splits or resizes).
+    const bool window_latency = !result.sample_latencies.empty();
+    std::cout << "Load time series:\n"
+              << "\t" << std::setw(10) << "time (ms)"
+              << std::setw(12) << "records";
+    if (window_latency)
+    {
+        std::cout << std::setw(10) << "50%"
+                  << std::setw(10) << "99%"
+                  << std::setw(10) << "99.9%"
+                  << std::setw(10) << "max";
+    }
+    std::cout << '\n';
+    for (size_t w = 0; w < result.samples.size(); ++w)
+    {
+        std::cout << "\t" << std::setw(10) << (w + 1) * result.sampling_ms
+                  << std::setw(12) << result.samples[w];
+        if (window_latency && w < result.sample_latencies.size() && result.sample_latencies[w].count > 0)
+        {
+            const auto& l = result.sample_latencies[w];
+            std::cout << std::setw(10) << l.p50
+                      << std::setw(10) << l.p99
+                      << std::setw(10) << l.p999
+                      << std::setw(10) << l.max;
+        }
+        std::cout << '\n';
     }
 
-    std::cout << "Load verified; benchmark started." << std::endl;
+    if (!result.verified)
+        std::cout << "Load not verified; benchmark started." << std::endl;
+    else if (result.missing == 0)
+        std::cout << "Load verified in " << result.verify_ms << " milliseconds; benchmark started." << std::endl;
+    else
+        std::cout << "WARNING: " << result.missing << " of " << result.records << " records not found after loading; benchmark started." << std::endl;
+}
+
+latency_summary_t benchmark_t::summarize(const histogram_t& h) const
+{
+    auto ns = [&](uint64_t ticks) { return static_cast<uint64_t>(std::llround(timer_.to_ns(ticks))); };
+    latency_summary_t l;
+    l.count = h.count();
+    l.mean = h.mean() * timer_.ns_per_tick();
+    l.min = ns(h.min());
+    l.p50 = ns(h.percentile(0.5));
+    l.p90 = ns(h.percentile(0.9));
+    l.p99 = ns(h.percentile(0.99));
+    l.p999 = ns(h.percentile(0.999));
+    l.p9999 = ns(h.percentile(0.9999));
+    l.p99999 = ns(h.percentile(0.99999));
+    l.max = ns(h.max());
+    return l;
 }
 
-void benchmark_t::run() noexcept
+result_t benchmark_t::run() noexcept
 {
+    // Time-based runs know their number of windows in advance. Memory is
+    // touched up front for at most MAX_WINDOWS of them, longer series grow.
+    size_t max_windows = 100000;
+    if (opt_.bm_mode == mode_t::Time)
+        max_windows = std::max<size_t>(max_windows, opt_.seconds * 1000 / opt_.sampling_ms + 1);
+    max_windows = std::min(max_windows, MAX_WINDOWS);
+
     std::vector<stats_t> global_stats;
-    global_stats.resize(100000); // Avoid overhead of allocation and page fault
+    global_stats.resize(max_windows); // Avoid overhead of allocation and page fault
     global_stats.resize(0);
 
     static thread_local char value_out[value_generator_t::VALUE_MAX];
     char* values_out;
 
-    std::vector<stats_t> local_stats(opt_.num_threads);
-    for(auto& lc : local_stats)
+    std::vector<thread_stats_t> local_stats(opt_.num_threads);
+
+    // Fixed-size latency histograms, one set per thread, merged after the run.
+    std::vector<latency_stats_t> local_latencies(opt_.num_threads);
+
+    // Latency histograms of the current sampling windows, one set per thread,
+    // and the percentiles of every window drained so far.
+    std::vector<window_latency_stats_t> local_windows(opt_.latency_sampling > 0.0 ? opt_.num_threads : 0);
+    std::vector<std::array<window_percentiles_t, NUM_OPERATIONS>> window_latencies;
+    if (opt_.latency_sampling > 0.0)
+        window_latencies.reserve(max_windows);
+
+    // Sampling window workers are currently recording latencies into
+    std::atomic<uint64_t> window(0);
+
+    // Windows stretched by a drain that ended late, whose latencies are skipped
+    std::vector<uint64_t> late_windows;
+
+    auto drain_window = [&](uint64_t w)
     {
-        if (opt_.bm_mode == mode_t::Operation)
-        {
-            lc.times.resize(std::ceil(opt_.num_ops/opt_.num_threads)*2);
-        }
+        bool skip = std::binary_search(late_windows.begin(), late_windows.end(), w);
+        window_latencies.push_back(drain_window_latencies(local_windows, w, skip));
+    };
+
+    // Control variables of monitor thread
+    std::atomic<bool> started(false);
+    std::atomic<bool> finished(false);
+
+    // First id to be inserted in this run. Threads take interleaved ids
+    // (first_insert_id + tid, + num_threads, ...), so the inserted ids stay
+    // dense regardless of how many inserts each thread ends up doing.
+    const uint64_t first_insert_id = next_insert_id_;
+
+    // Timer overhead to be subtracted from every latency measurement
+    uint64_t overhead = opt_.subtract_timer_overhead ? timer_.overhead() : 0;
+
+    // A moving hot set is moved by the monitor thread at the end of every
+    // 'hot_windows' sampling windows, so each window has a single hot set.
+    auto hotspot = opt_.hot_shift != hot_shift_t::NONE
+                       ? dynamic_cast<hotspot_key_generator_t*>(key_generator_.get())
+                       : nullptr;
+    const uint64_t hot_windows = std::max<int64_t>(1, std::llround(opt_.hot_shift_ms / opt_.sampling_ms));
+    xoshiro256pp_engine hot_gen(stream_seed(opt_.rnd_seed, 0, random_stream_t::HOT_SET));
+    std::vector<uint64_t> hot_shift_windows;
+    auto shift_hot_set = [&]()
+    {
+        uint64_t N = hotspot->keyspace();
+        if (opt_.hot_shift == hot_shift_t::SLIDE)
+            hotspot->set_hot_start(hotspot->hot_start() + std::max<int64_t>(1, std::llround(opt_.hot_step * N)));
         else
-        {
-            lc.times.resize(1000000);
-        }
-        lc.times.resize(0);
-    }
+            hotspot->set_hot_start(std::uniform_int_distribution<uint64_t>(0, N - 1)(hot_gen));
+        hot_shift_windows.push_back(global_stats.size());
+    };
 
-    // Control variable of monitor thread
-    bool finished = false;
+    // In open-loop mode each thread issues requests at 1/num_threads of the
+    // target rate, and latency is measured from the intended start time.
+    const bool open_loop = opt_.rate > 0.0;
+    const double interval = open_loop ? opt_.num_threads * 1e9 / opt_.rate / timer_.ns_per_tick() : 0.0;
 
-    // The amount of inserts expected to be done by each thread + some play room.
-    uint64_t inserts_per_thread = 10 + (opt_.num_ops * opt_.insert_ratio) / opt_.num_threads;
+    // How far behind schedule each thread is when finished (in ticks).
+    std::vector<double> lag(opt_.num_threads, 0.0);
+
+    // Per-thread streams of requests when pre-generating. Operations are
+    // stored in one byte, flagged if their latency is to be measured.
+    struct arena_t
+    {
+        std::vector<uint8_t> ops;
+        std::vector<char> keys;
+    };
+    static constexpr uint8_t MEASURE_LATENCY = 0x80;
+    std::vector<arena_t> arenas(opt_.num_threads);
+
+    // Reads or inserts buffered by a thread to be issued as one batch. Keys
+    // are copied, as generated keys only live until the next one.
+    struct batch_t
+    {
+        operation_t op;
+        size_t count = 0;
+        bool measure_latency = false;
+        uint32_t value_size = 0;
+        std::vector<char> keys;
+        std::vector<const char*> key_ptrs;
+        std::vector<const char*> values;
+    };
+
+    // Lookup in flight when interleaving, with its own copy of the key and
+    // buffer for the value, valid until it completes.
+    struct lookup_t
+    {
+        bool busy = false;
+        bool measure_latency = false;
+        uint64_t start = 0;
+        char* state = nullptr;
+        char* key = nullptr;
+        char* value_out = nullptr;
+    };
+    std::vector<double> generation_ms(opt_.num_threads, 0.0);
+    const size_t key_size = key_generator_->size();
+
+    // Trace this run is recorded to, or replayed from. A recorded trace is
+    // written before the run starts, and the run then replays it.
+    std::unique_ptr<trace_writer_t> recorder;
+    std::unique_ptr<trace_reader_t> trace;
+    try
+    {
+        if (!opt_.record_trace.empty())
+            recorder = std::make_unique<trace_writer_t>(opt_.record_trace, key_size);
+        else if (!opt_.replay_trace.empty())
+            trace = std::make_unique<trace_reader_t>(opt_.replay_trace);
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+    if (trace && trace->key_size() != key_size)
+    {
+        std::cout << "Error: trace has keys of " << trace->key_size() << " Bytes, but key size is " << key_size << std::endl;
+        exit(1);
+    }
 
-    // Current id after load
-    uint64_t current_id = key_generator_->current_id_;
+    // Workers are pinned according to the affinity policy, and the monitor
+    // somewhere it does not compete with them.
+    auto cpus = placement(opt_.num_threads);
+    int monitor_cpu = cpus.empty() ? -1 : pick_monitor_cpu(topology_, cpus);
+    std::vector<int> worker_cpus(opt_.num_threads, -1);
 
     std::unique_ptr<SystemCounterState> before_sstate;
     if (opt_.enable_pcm)
@@ -234,34 +1005,71 @@ void benchmark_t::run() noexcept
     {
         #pragma omp section // Monitor thread
         {
-            std::chrono::milliseconds sampling_window(opt_.sampling_ms);
+            if (monitor_cpu >= 0)
+            {
+                pin_thread(monitor_cpu);
+            }
+            else if (!cpus.empty())
+            {
+                // No CPU left, let it float (the thread may have been pinned before)
+                std::vector<uint32_t> all;
+                for (auto& c : topology_)
+                    all.push_back(c.id);
+                pin_thread(all);
+            }
+
+            // Requests may be generated before the run, do not sample until
+            // the workers start.
+            while (!started.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+            // Windows are scheduled on absolute deadlines, so the time spent
+            // sampling does not make them drift.
+            using clock = std::chrono::steady_clock;
+            auto sampling_window = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double, std::milli>(opt_.sampling_ms));
+            auto next_sample = clock::now();
             auto sample_stats = [&]()
             {
-                std::this_thread::sleep_for(sampling_window);
+                next_sample += sampling_window;
+                std::this_thread::sleep_until(next_sample);
                 stats_t s;
-                s.operation_count = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                        return sum + curr.operation_count;
-                                                    });
+                for (auto& l : local_stats)
+                    s += l.snapshot();
                 global_stats.push_back(std::move(s));
+
+                if (hotspot && global_stats.size() % hot_windows == 0)
+                    shift_hot_set();
+
+                if (opt_.latency_sampling > 0.0)
+                {
+                    // Move workers on to the next window and drain the one
+                    // before the window that just ended.
+                    auto w = window.load(std::memory_order_relaxed);
+                    window.store(w + 1, std::memory_order_relaxed);
+                    if (w > 0)
+                        drain_window(w - 1);
+                    if (clock::now() > next_sample + sampling_window)
+                        late_windows.push_back(w + 1);
+                }
             };
 
             if (opt_.bm_mode == mode_t::Operation)
             {
-                while (!finished)
+                while (!finished.load(std::memory_order_acquire))
                 {
                     sample_stats();
                 }
             }
             else
             {
-                uint32_t iterations = opt_.seconds * 1000 / opt_.sampling_ms;
-                uint32_t slept = 0;
+                uint64_t iterations = std::llround(opt_.seconds * 1000 / opt_.sampling_ms);
+                uint64_t slept = 0;
                 do {
                     sample_stats();
                 }
                 while (++slept < iterations);
-                finished = true;
+                finished.store(true, std::memory_order_release);
             }
         }
 
@@ -271,90 +1079,417 @@ void benchmark_t::run() noexcept
             {
                 auto tid = omp_get_thread_num();
 
+                if (!cpus.empty())
+                    pin_thread(cpus[tid]);
+                set_mempolicy(opt_.run_mempolicy);
+                worker_cpus[tid] = current_cpu();
+
                 // Initialize random seed for each thread
-                key_generator_->set_seed(opt_.rnd_seed * (tid + 1));
+                key_generator_->set_seed(stream_seed(opt_.rnd_seed, tid, random_stream_t::KEY));
 
                 // Initialize insert id for each thread
-                key_generator_->current_id_ = current_id + (inserts_per_thread * tid);
+                uint64_t insert_id = first_insert_id + tid;
 
                 auto random_bool = std::bind(std::bernoulli_distribution(opt_.latency_sampling), std::knuth_b());
 
-                #pragma omp barrier
-
-                #pragma omp single nowait
+                xoshiro256pp_engine scan_gen(stream_seed(opt_.rnd_seed, tid, random_stream_t::SCAN));
+                std::uniform_int_distribution<uint32_t> scan_dist(1, opt_.scan_size);
+                auto next_scan_size = [&]()
                 {
-                    sw.start();
-                }
+                    return opt_.scan_length == scan_length_t::UNIFORM ? scan_dist(scan_gen) : opt_.scan_size;
+                };
 
-                auto execute_op = [&]()
+                xoshiro256pp_engine arrival_gen(stream_seed(opt_.rnd_seed, tid, random_stream_t::ARRIVAL));
+                std::exponential_distribution<double> arrival_dist(1.0);
+                auto next_interval = [&]()
                 {
-                    // Generate random operation
-                    auto op = op_generator_.next();
+                    return opt_.arrival == arrival_t::POISSON ? interval * arrival_dist(arrival_gen) : interval;
+                };
+
+                // Insert frontier last seen by this thread (LATEST only)
+                static constexpr uint64_t FRONTIER_REFRESH = 64;
+                uint64_t newest = 0;
+                uint64_t frontier_age = 0;
 
-                    // Generate random scrambled key
-                    const char *key_ptr = nullptr;
+                // Generate random operation and random scrambled key
+                auto next_request = [&](operation_t& op, const char*& key_ptr)
+                {
+                    op = op_generator_.next();
                     if (op == operation_t::INSERT)
                     {
-                        key_ptr = key_generator_->next(true);
+                        key_ptr = key_generator_->hash_id(insert_id);
+                        insert_id += opt_.num_threads;
                     }
-                    else
+                    else if (opt_.key_distribution == distribution_t::LATEST)
+                    {
+                        // Rank 1 is the newest record. The global insert
+                        // frontier is refreshed every few requests, which
+                        // keeps the counters of other threads off the hot
+                        // path. Streams generated ahead of the run can only
+                        // count on the inserts of their own thread, assuming
+                        // all threads insert at the same pace.
+                        auto rank = key_generator_->next_id();
+                        if (opt_.pregenerate)
+                            newest = insert_id > opt_.num_threads ? insert_id - opt_.num_threads : 0;
+                        else if (frontier_age++ % FRONTIER_REFRESH == 0)
+                            newest = insert_frontier(first_insert_id, local_stats);
+                        key_ptr = key_generator_->hash_id(latest_id(rank, newest));
+                    }
+                    else if (opt_.bm_mode == mode_t::Time)
                     {
+                        // Scale back to the ids inserted so far, assuming
+                        // all threads insert at the same pace.
                         auto id = key_generator_->next_id();
-                        if (opt_.bm_mode == mode_t::Time)
-                        {
-                            // Scale back to insert amount
-                            id %= (local_stats[tid].success_insert_count * opt_.num_threads + opt_.num_records);
-                            if (id >= opt_.num_records) {
-                                uint64_t ins = id - opt_.num_records;
-                                id = opt_.num_records + inserts_per_thread * (ins / local_stats[tid].success_insert_count) + ins % local_stats[tid].success_insert_count;
-                            }
-                        }
+                        id = 1 + (id - 1) % (first_insert_id - 1 + local_stats[tid].completed(operation_t::INSERT) * opt_.num_threads);
                         key_ptr = key_generator_->hash_id(id);
                     }
-
-                    auto measure_latency = random_bool();
-                    if (measure_latency)
+                    else
                     {
-                        local_stats[tid].times.push_back(std::chrono::high_resolution_clock::now());
+                        // Ids are used as drawn, so keys are generated in batches
+                        key_ptr = key_generator_->next_batched();
                     }
+                };
 
-                    run_op(op, key_ptr, value_out, values_out, measure_latency, local_stats[tid]);
+                // Materialize the whole stream of this thread before the run,
+                // so the timed loop only replays it.
+                auto& arena = arenas[tid];
+                if (opt_.pregenerate)
+                {
+                    stopwatch_t gen_sw;
+                    gen_sw.start();
 
-                    if (measure_latency)
+                    uint64_t count = opt_.num_ops / opt_.num_threads + (tid < opt_.num_ops % opt_.num_threads);
+                    arena.ops.resize(count);
+                    arena.keys.resize(count * key_size);
+                    for (uint64_t i = 0; i < count; ++i)
                     {
-                        local_stats[tid].times.push_back(std::chrono::high_resolution_clock::now());
+                        operation_t op;
+                        const char* key_ptr;
+                        next_request(op, key_ptr);
+                        arena.ops[i] = static_cast<uint8_t>(op) | (random_bool() ? MEASURE_LATENCY : 0);
+                        memcpy(&arena.keys[i * key_size], key_ptr, key_size);
                     }
-                };
+                    generation_ms[tid] = gen_sw.elapsed<std::chrono::milliseconds>();
+                }
 
-                if (opt_.bm_mode == mode_t::Operation)
+                if (recorder)
                 {
-                    #pragma omp for schedule(static)
+                    // Each thread writes its stream to its own partition of
+                    // the trace, which is replayed the same way.
+                    static constexpr uint64_t BATCH = 4096;
+                    auto record_size = recorder->record_size();
+                    std::vector<char> buf(BATCH * record_size);
+                    uint64_t first, last;
+                    trace_partition(opt_.num_ops, opt_.num_threads, tid, first, last);
+                    try
+                    {
+                        for (uint64_t i = first; i < last; i += BATCH)
+                        {
+                            auto n = std::min(BATCH, last - i);
+                            for (uint64_t j = 0; j < n; ++j)
+                            {
+                                operation_t op;
+                                const char* key_ptr;
+                                next_request(op, key_ptr);
+                                auto value_size = op == operation_t::INSERT || op == operation_t::UPDATE
+                                                  || op == operation_t::READ_MODIFY_WRITE ? opt_.value_size : 0;
+                                auto scan_size = op == operation_t::SCAN ? next_scan_size() : 0;
+                                recorder->encode(&buf[j * record_size], op, key_ptr, value_size, scan_size);
+                            }
+                            recorder->write(i, buf.data(), n);
+                        }
+
+                        #pragma omp barrier
+
+                        #pragma omp single
+                        {
+                            recorder->close();
+                            trace = std::make_unique<trace_reader_t>(opt_.record_trace);
+                        }
+                    }
+                    catch (const std::exception& e)
+                    {
+                        #pragma omp critical
+                        std::cout << "Error recording trace: " << e.what() << std::endl;
+                        exit(1);
+                    }
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single nowait
+                {
+                    sw.start();
+                    started.store(true, std::memory_order_release);
+                }
+
+                // Stagger threads so that arrivals are evenly spread
+                double next_arrival = timer_.start() + (opt_.arrival == arrival_t::POISSON
+                                                        ? next_interval()
+                                                        : interval * tid / opt_.num_threads);
+
+                auto discount = [&](uint64_t ticks) { return ticks > overhead ? ticks - overhead : 0; };
+
+                auto execute_op = [&](operation_t op, const char* key_ptr, bool measure_latency,
+                                      uint32_t value_size, uint32_t scan_size)
+                {
+                    uint64_t intended = 0;
+                    uint64_t start = 0;
+                    if (open_loop)
+                    {
+                        // Busy-wait until the scheduled arrival. If we are
+                        // behind schedule, issue immediately.
+                        intended = next_arrival;
+                        next_arrival += next_interval();
+                        do
+                        {
+                            start = timer_.start();
+                        }
+                        while (start < intended);
+                    }
+                    else if (measure_latency)
+                    {
+                        start = timer_.start();
+                    }
+
+                    auto r = run_op(op, key_ptr, value_size, scan_size, value_out, values_out, measure_latency, local_stats[tid]);
+
+                    if (measure_latency)
+                    {
+                        auto end = timer_.stop();
+
+                        // Include the time spent queued behind previous requests
+                        auto latency = discount(end - (open_loop ? intended : start));
+                        local_latencies[tid].record(op, r, latency);
+                        auto w = window.load(std::memory_order_relaxed) % window_latency_stats_t::SLOTS;
+                        local_windows[tid].ops[w][static_cast<size_t>(op)].record(latency);
+                        if (open_loop)
+                            local_latencies[tid].service.record(discount(end - start));
+                    }
+                };
+
+                // Reads and inserts are buffered per type when batching. A
+                // batch is sampled for latency if the request opening it is.
+                const size_t batch_size = opt_.batch_size;
+                batch_t batches[2];
+                std::vector<char> batch_values_out;
+                std::vector<char*> batch_values_out_ptrs;
+                std::unique_ptr<bool[]> batch_succeeded;
+                if (batch_size > 1)
+                {
+                    for (size_t j = 0; j < 2; ++j)
+                    {
+                        auto& b = batches[j];
+                        b.op = j == 0 ? operation_t::READ : operation_t::INSERT;
+                        b.keys.resize(batch_size * key_size);
+                        b.values.resize(batch_size);
+                        for (size_t i = 0; i < batch_size; ++i)
+                            b.key_ptrs.push_back(&b.keys[i * key_size]);
+                    }
+                    batch_values_out.resize(batch_size * value_generator_t::VALUE_MAX);
+                    for (size_t i = 0; i < batch_size; ++i)
+                        batch_values_out_ptrs.push_back(&batch_values_out[i * value_generator_t::VALUE_MAX]);
+                    batch_succeeded.reset(new bool[batch_size]);
+                }
+
+                auto flush_batch = [&](batch_t& b)
+                {
+                    if (b.count == 0)
+                        return;
+
+                    uint64_t start = b.measure_latency ? timer_.start() : 0;
+                    run_batch(b.op, b.count, b.key_ptrs.data(), b.values.data(), b.value_size,
+                              batch_values_out_ptrs.data(), batch_succeeded.get(), local_stats[tid]);
+
+                    if (b.measure_latency)
+                    {
+                        auto latency = discount(timer_.stop() - start);
+                        local_latencies[tid].batch.record(latency);
+
+                        // Amortize the batch latency over its operations
+                        auto per_op = latency / b.count;
+                        auto w = window.load(std::memory_order_relaxed) % window_latency_stats_t::SLOTS;
+                        for (size_t i = 0; i < b.count; ++i)
+                        {
+                            local_latencies[tid].record(b.op, batch_succeeded[i], per_op);
+                            local_windows[tid].ops[w][static_cast<size_t>(b.op)].record(per_op);
+                        }
+                    }
+                    b.count = 0;
+                };
+
+                // Lookups in flight when interleaving, advanced round-robin
+                const size_t interleave = opt_.interleave;
+                std::vector<lookup_t> lookups(interleave > 1 ? interleave : 0);
+                std::vector<char> lookup_buf;
+                size_t in_flight = 0;
+                size_t next_lookup = 0;
+                if (interleave > 1)
+                {
+                    auto align = [](size_t n) { return (n + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t); };
+                    auto state_size = align(tree_->find_state_size());
+                    auto stride = state_size + align(key_size) + value_generator_t::VALUE_MAX;
+                    lookup_buf.resize(interleave * stride);
+                    for (size_t i = 0; i < interleave; ++i)
+                    {
+                        lookups[i].state = &lookup_buf[i * stride];
+                        lookups[i].key = lookups[i].state + state_size;
+                        lookups[i].value_out = lookups[i].key + align(key_size);
+                    }
+                }
+
+                // Advance a lookup by one step, and account for it if complete
+                auto step_lookup = [&](lookup_t& l)
+                {
+                    bool found;
+                    if (!tree_->find_step(l.state, found))
+                        return;
+
+                    local_stats[tid].record(operation_t::READ, found);
+                    if (l.measure_latency)
+                    {
+                        auto latency = discount(timer_.stop() - l.start);
+                        local_latencies[tid].record(operation_t::READ, found, latency);
+                        auto w = window.load(std::memory_order_relaxed) % window_latency_stats_t::SLOTS;
+                        local_windows[tid].ops[w][static_cast<size_t>(operation_t::READ)].record(latency);
+                    }
+                    l.busy = false;
+                    --in_flight;
+                };
+
+                auto start_lookup = [&](const char* key_ptr, bool measure_latency)
+                {
+                    // Step through the lookups in flight until a slot is free
+                    while (lookups[next_lookup].busy)
+                    {
+                        step_lookup(lookups[next_lookup]);
+                        if (lookups[next_lookup].busy)
+                            next_lookup = (next_lookup + 1) % interleave;
+                    }
+
+                    auto& l = lookups[next_lookup];
+                    memcpy(l.key, key_ptr, key_size);
+                    l.busy = true;
+                    l.measure_latency = measure_latency;
+                    l.start = measure_latency ? timer_.start() : 0;
+                    ++in_flight;
+                    tree_->find_start(l.state, l.key, key_size, l.value_out);
+                    next_lookup = (next_lookup + 1) % interleave;
+                };
+
+                auto submit = [&](operation_t op, const char* key_ptr, bool measure_latency,
+                                  uint32_t value_size, uint32_t scan_size)
+                {
+                    if (interleave > 1 && op == operation_t::READ)
+                    {
+                        start_lookup(key_ptr, measure_latency);
+                        return;
+                    }
+
+                    if (batch_size == 1 || (op != operation_t::READ && op != operation_t::INSERT))
+                    {
+                        execute_op(op, key_ptr, measure_latency, value_size, scan_size);
+                        return;
+                    }
+
+                    auto& b = batches[op == operation_t::INSERT];
+                    if (b.count > 0 && b.value_size != value_size)
+                        flush_batch(b);
+                    if (b.count == 0)
+                    {
+                        b.measure_latency = measure_latency;
+                        b.value_size = value_size;
+                    }
+                    memcpy(&b.keys[b.count * key_size], key_ptr, key_size);
+                    if (op == operation_t::INSERT)
+                        b.values[b.count] = value_generator_.next(value_size);
+                    if (++b.count == batch_size)
+                        flush_batch(b);
+                };
+
+                operation_t op;
+                const char* key_ptr;
+                if (opt_.pregenerate)
+                {
+                    for (uint64_t i = 0; i < arena.ops.size(); ++i)
+                    {
+                        auto r = arena.ops[i];
+                        submit(static_cast<operation_t>(r & ~MEASURE_LATENCY), &arena.keys[i * key_size],
+                               r & MEASURE_LATENCY, opt_.value_size, next_scan_size());
+                    }
+                }
+                else if (trace)
+                {
+                    uint64_t first, last;
+                    trace_partition(trace->size(), opt_.num_threads, tid, first, last);
+                    trace_cursor_t cursor(*trace, first, last);
+                    trace_request_t request;
+                    while (cursor.next(request))
+                    {
+                        submit(request.op, request.key, random_bool(),
+                               std::min(request.value_size, value_generator_t::VALUE_MAX),
+                               std::min<uint32_t>(request.scan_size, MAX_SCAN));
+                    }
+                }
+                else if (opt_.bm_mode == mode_t::Operation)
+                {
+                    #pragma omp for schedule(static) nowait
                     for (uint64_t i = 0; i < opt_.num_ops; ++i)
                     {
-                        execute_op();
+                        next_request(op, key_ptr);
+                        submit(op, key_ptr, random_bool(), opt_.value_size, next_scan_size());
                     }
                 }
                 else
                 {
-                    uint32_t slept = 0;
                     do
                     {
-                        execute_op();
+                        next_request(op, key_ptr);
+                        submit(op, key_ptr, random_bool(), opt_.value_size, next_scan_size());
+                    }
+                    while (!finished.load(std::memory_order_acquire));
+                }
+
+                // Issue what is left of partially filled batches, and
+                // complete the lookups still in flight
+                for (auto& b : batches)
+                    flush_batch(b);
+                while (in_flight > 0)
+                {
+                    for (auto& l : lookups)
+                    {
+                        if (l.busy)
+                            step_lookup(l);
                     }
-                    while (!finished);
                 }
 
+                // Operation mode runs until every thread is done
+                if (opt_.bm_mode == mode_t::Operation)
+                {
+                    #pragma omp barrier
+                }
+
+                if (open_loop)
+                    lag[tid] = std::max(0.0, timer_.stop() - next_arrival);
+
                 // Get elapsed time and signal monitor thread to finish.
                 #pragma omp single nowait
                 {
                     elapsed = sw.elapsed<std::chrono::milliseconds>();
-                    finished = true;
+                    finished.store(true, std::memory_order_release);
                 }
             }
         }
     }
     omp_set_nested(false);
 
+    // Workers are done, the last window can be drained safely. Anything
+    // recorded after the monitor's last sample is not part of any window.
+    if (opt_.latency_sampling > 0.0 && !global_stats.empty())
+        drain_window(global_stats.size() - 1);
+    warn_late_windows(std::lower_bound(late_windows.begin(), late_windows.end(), global_stats.size()) - late_windows.begin(),
+                      opt_.sampling_ms);
+
     std::unique_ptr<SystemCounterState> after_sstate;
     if (opt_.enable_pcm)
     {
@@ -362,203 +1497,438 @@ void benchmark_t::run() noexcept
         *after_sstate = getSystemCounterState();
     }
 
-    std::cout << std::fixed << std::setprecision(4);
-    std::cout << "\tRun time: " << elapsed << " milliseconds" << std::endl;
+    // Following runs insert after the ids taken by this one
+    uint64_t max_inserts = 0;
+    for (auto& s : local_stats)
+        max_inserts = std::max(max_inserts, s.completed(operation_t::INSERT));
+    next_insert_id_ = first_insert_id + max_inserts * opt_.num_threads;
+
+    result_t result;
+    result.opt = opt_;
+    result.elapsed_ms = elapsed;
+    for (auto& s : local_stats)
+        result.total += s.snapshot();
+
+    if (open_loop)
+        result.schedule_lag_ms = timer_.to_ns(*std::max_element(lag.begin(), lag.end())) / 1e6;
+
+    if (opt_.enable_pcm)
+    {
+        result.has_pcm = true;
+        result.l3_misses = getL3CacheMisses(*before_sstate, *after_sstate);
+        result.dram_reads = getBytesReadFromMC(*before_sstate, *after_sstate);
+        result.dram_writes = getBytesWrittenToMC(*before_sstate, *after_sstate);
+        result.nvm_reads = getBytesReadFromPMM(*before_sstate, *after_sstate);
+        result.nvm_writes = getBytesWrittenToPMM(*before_sstate, *after_sstate);
+    }
+
+    std::adjacent_difference(global_stats.begin(), global_stats.end(), global_stats.begin(),
+                             [](const stats_t& x, const stats_t& y) {
+                                 stats_t s = x;
+                                 s -= y;
+                                 return s;
+                             });
+    result.samples = std::move(global_stats);
+    result.hot_shifts = summarize_hot_shifts(result.samples, hot_shift_windows, opt_.sampling_ms);
 
-    uint64_t total_ops = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.operation_count;
-                                         });
-
-    uint64_t total_success_ops = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.success_insert_count
-                                                       + curr.success_read_count
-                                                       + curr.success_update_count
-                                                       + curr.success_remove_count
-                                                       + curr.success_scan_count;
-                                         });
-
-    uint64_t total_insert = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.insert_count;
-                                         });
-
-    uint64_t total_success_insert = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                       return sum + curr.success_insert_count;
-                                                    });
-
-    uint64_t total_read = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.read_count;
-                                         });
-
-    uint64_t total_success_read = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                       return sum + curr.success_read_count;
-                                                    });
-
-    uint64_t total_update = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.update_count;
-                                         });
-
-    uint64_t total_success_update = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                       return sum + curr.success_update_count;
-                                                    });
-
-    uint64_t total_remove = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.remove_count;
-                                         });
-
-    uint64_t total_success_remove = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                       return sum + curr.success_remove_count;
-                                                    });
-
-    uint64_t total_scan = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                         [](uint64_t sum, const stats_t& curr) {
-                                            return sum + curr.scan_count;
-                                         });
-
-    uint64_t total_success_scan = std::accumulate(local_stats.begin(), local_stats.end(), 0ull,
-                                                    [](uint64_t sum, const stats_t& curr) {
-                                                       return sum + curr.success_scan_count;
-                                                    });
-
-
-    if (opt_.bm_mode == mode_t::Operation && opt_.num_ops != total_ops)
+    // Histograms are recorded in timer ticks, results are in nanoseconds
+    auto ns = [&](uint64_t ticks) { return static_cast<uint64_t>(std::llround(timer_.to_ns(ticks))); };
+    for (auto& w : window_latencies)
+    {
+        for (auto& l : w)
+        {
+            l.p50 = ns(l.p50);
+            l.p99 = ns(l.p99);
+            l.p999 = ns(l.p999);
+            l.max = ns(l.max);
+        }
+    }
+    result.sample_latencies = std::move(window_latencies);
+
+    if (opt_.pregenerate)
+    {
+        result.generation_ms = *std::max_element(generation_ms.begin(), generation_ms.end());
+        result.generation_ns_per_op = std::accumulate(generation_ms.begin(), generation_ms.end(), 0.0) * 1e6 / opt_.num_ops;
+    }
+
+    result.worker_cpus = worker_cpus;
+    for (auto cpu : worker_cpus)
+    {
+        auto info = cpu_info(cpu);
+        result.worker_nodes.push_back(info ? info->node : -1);
+    }
+    result.monitor_cpu = monitor_cpu;
+
+    result.timer = timer_.source();
+    result.timer_ns_per_tick = timer_.ns_per_tick();
+    result.timer_min_overhead_ns = ns(timer_.min_overhead());
+    result.timer_overhead_ns = ns(timer_.overhead());
+
+    if (opt_.latency_sampling > 0.0)
+    {
+        // Merge per-thread histograms by operation type and outcome
+        auto all = std::make_unique<histogram_t>();
+        auto op_all = std::make_unique<histogram_t>();
+        auto op_outcome = std::make_unique<histogram_t>();
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            op_all->reset();
+            for (size_t succeeded = 0; succeeded < 2; ++succeeded)
+            {
+                op_outcome->reset();
+                for (auto& l : local_latencies)
+                    op_outcome->merge(l.ops[op][succeeded]);
+                op_all->merge(*op_outcome);
+                (succeeded ? result.op_succeeded_latency : result.op_failed_latency)[op] = summarize(*op_outcome);
+            }
+            all->merge(*op_all);
+            result.op_latency[op] = summarize(*op_all);
+        }
+        result.has_latency = true;
+        result.latency = summarize(*all);
+
+        if (open_loop)
+        {
+            all->reset();
+            for (auto& l : local_latencies)
+                all->merge(l.service);
+            result.service_latency = summarize(*all);
+        }
+
+        if (opt_.batch_size > 1)
+        {
+            all->reset();
+            for (auto& l : local_latencies)
+                all->merge(l.batch);
+            result.batch_latency = summarize(*all);
+        }
+    }
+
+    // Breakdown by socket of the workers, to expose cross-socket penalties.
+    // Only meaningful if workers are pinned and cannot migrate.
+    if (!cpus.empty())
+    {
+        std::map<uint32_t, std::unique_ptr<histogram_t>> socket_latencies;
+        for (uint32_t tid = 0; tid < opt_.num_threads; ++tid)
+        {
+            auto info = cpu_info(worker_cpus[tid]);
+            uint32_t socket = info ? info->socket : 0;
+
+            auto it = std::find_if(result.sockets.begin(), result.sockets.end(),
+                                   [&](const socket_result_t& r) { return r.socket == socket; });
+            if (it == result.sockets.end())
+            {
+                result.sockets.emplace_back();
+                result.sockets.back().socket = socket;
+                socket_latencies[socket] = std::make_unique<histogram_t>();
+                it = result.sockets.end() - 1;
+            }
+
+            ++it->threads;
+            it->total += local_stats[tid].snapshot();
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+                for (size_t succeeded = 0; succeeded < 2; ++succeeded)
+                    socket_latencies[socket]->merge(local_latencies[tid].ops[op][succeeded]);
+        }
+
+        std::sort(result.sockets.begin(), result.sockets.end(),
+                  [](const socket_result_t& a, const socket_result_t& b) { return a.socket < b.socket; });
+        for (auto& r : result.sockets)
+            r.latency = summarize(*socket_latencies[r.socket]);
+    }
+
+    if (opt_.bm_mode == mode_t::Operation && opt_.num_ops != result.total.operation_count)
     {
         std::cout << "Fatal: Total operations specified/performed don't match!";
         exit(1);
     }
 
+    print_result(result);
+    return result;
+}
+
+void benchmark_t::print_result(const result_t& result) const
+{
+    const auto& total = result.total;
+    const double elapsed = result.elapsed_ms;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "\tRun time: " << elapsed << " milliseconds" << std::endl;
+
     std::cout << "Results:\n";
-    std::cout << "\tOperations: " << total_ops << std::endl;
-    std::cout << "\tThroughput:\n" 
-              << "\t- Completed: " << total_ops / ((double)elapsed / 1000) << " ops/s\n" 
-              << "\t- Succeeded: " << total_success_ops / ((double)elapsed / 1000) << " ops/s\n" 
-              << "\tBreakdown:\n"
-              << "\t- Insert completed: " << total_insert / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Insert succeeded: " << total_success_insert / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Read completed: " << total_read / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Read succeeded: " << total_success_read / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Update completed: " << total_update / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Update succeeded: " << total_success_update / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Remove completed: " << total_remove / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Remove succeeded: " << total_success_remove/ ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Scan completed: " << total_scan / ((double)elapsed / 1000) << " ops/s\n"
-              << "\t- Scan succeeded: " << total_success_scan/ ((double)elapsed / 1000) << " ops/s"
-              << std::endl;
+    std::cout << "\tOperations: " << total.operation_count << std::endl;
+    if (result.opt.pregenerate && total.operation_count > 0)
+    {
+        // Per-thread time of an operation with the generator cost excluded
+        double op_ns = elapsed * 1e6 * result.opt.num_threads / total.operation_count;
+        std::cout << "\tPre-generation: " << result.generation_ms << " milliseconds ("
+                  << result.generation_ns_per_op << " ns/op per thread)\n"
+                  << "\tGenerator share of an inline operation: "
+                  << 100 * result.generation_ns_per_op / (result.generation_ns_per_op + op_ns) << "%" << std::endl;
+    }
+    if (result.opt.rate > 0.0)
+    {
+        std::cout << "\tOffered load: " << result.opt.rate << " ops/s\n"
+                  << "\tSchedule lag: " << result.schedule_lag_ms << " milliseconds" << std::endl;
+    }
+    std::cout << "\tThroughput:\n"
+              << "\t- Completed: " << total.operation_count / ((double)elapsed / 1000) << " ops/s\n"
+              << "\t- Succeeded: " << total.succeeded_count() / ((double)elapsed / 1000) << " ops/s\n"
+              << "\tBreakdown:";
+    for (auto op : {operation_t::INSERT, operation_t::READ, operation_t::UPDATE, operation_t::REMOVE, operation_t::SCAN,
+                    operation_t::READ_MODIFY_WRITE})
+    {
+        auto i = static_cast<size_t>(op);
+        std::cout << "\n\t- " << op << " completed: " << total.completed[i] / ((double)elapsed / 1000) << " ops/s"
+                  << "\n\t- " << op << " succeeded: " << total.succeeded[i] / ((double)elapsed / 1000) << " ops/s";
+    }
+    std::cout << std::endl;
 
-    if (opt_.enable_pcm)
+    std::cout << "Placement: " << result.opt.affinity
+              << (result.opt.affinity == affinity_t::NONE ? " (CPU at start of run)" : "") << "\n";
+    if (result.monitor_cpu >= 0)
+        std::cout << "\tMonitor: CPU " << result.monitor_cpu << "\n";
+    for (size_t tid = 0; tid < result.worker_cpus.size(); ++tid)
+    {
+        std::cout << "\tThread " << tid << ": CPU " << result.worker_cpus[tid]
+                  << " (node " << result.worker_nodes[tid] << ")\n";
+    }
+    std::cout << std::flush;
+
+    if (!result.sockets.empty())
+    {
+        std::cout << "Socket breakdown:\n"
+                  << "\t" << std::left << std::setw(8) << "Socket" << std::right
+                  << std::setw(9) << "threads"
+                  << std::setw(16) << "completed/s"
+                  << std::setw(16) << "succeeded/s";
+        if (result.has_latency)
+            std::cout << std::setw(10) << "50%" << std::setw(10) << "99%" << std::setw(10) << "99.9%";
+        std::cout << '\n';
+        for (auto& s : result.sockets)
+        {
+            std::cout << "\t" << std::left << std::setw(8) << s.socket << std::right
+                      << std::setw(9) << s.threads
+                      << std::setw(16) << s.total.operation_count / ((double)elapsed / 1000)
+                      << std::setw(16) << s.total.succeeded_count() / ((double)elapsed / 1000);
+            if (result.has_latency)
+            {
+                std::cout << std::setw(10) << s.latency.p50
+                          << std::setw(10) << s.latency.p99
+                          << std::setw(10) << s.latency.p999;
+            }
+            std::cout << '\n';
+        }
+        std::cout << std::flush;
+    }
+
+    if (result.has_pcm)
     {
         std::cout << "PCM Metrics:"
                   << "\n"
-                  << "\tL3 misses: " << getL3CacheMisses(*before_sstate, *after_sstate) << "\n"
-                  << "\tDRAM Reads (bytes): " << getBytesReadFromMC(*before_sstate, *after_sstate) << "\n"
-                  << "\tDRAM Writes (bytes): " << getBytesWrittenToMC(*before_sstate, *after_sstate) << "\n"
-                  << "\tNVM Reads (bytes): " << getBytesReadFromPMM(*before_sstate, *after_sstate) << "\n"
-                  << "\tNVM Writes (bytes): " << getBytesWrittenToPMM(*before_sstate, *after_sstate) << std::endl;
+                  << "\tL3 misses: " << result.l3_misses << "\n"
+                  << "\tDRAM Reads (bytes): " << result.dram_reads << "\n"
+                  << "\tDRAM Writes (bytes): " << result.dram_writes << "\n"
+                  << "\tNVM Reads (bytes): " << result.nvm_reads << "\n"
+                  << "\tNVM Writes (bytes): " << result.nvm_writes << std::endl;
     }
 
     std::cout << "Samples:" << std::endl;
-    std::adjacent_difference(global_stats.begin(), global_stats.end(), global_stats.begin(),
-                             [](const stats_t& x, const stats_t& y) {
-                                 stats_t s;
-                                 s.operation_count = x.operation_count - y.operation_count;
-                                 return s;
-                             });
-
-    for (auto s : global_stats)
+    for (auto s : result.samples)
         std::cout << "\t" << s.operation_count << std::endl;
 
-    if(opt_.latency_sampling > 0.0)
+    // Per-window breakdown by operation type. Latency percentiles make
+    // structural events (e.g., splits, compactions) show up as spikes.
+    const bool window_latency = !result.sample_latencies.empty();
+    std::cout << "Time series:\n"
+              << "\t" << std::setw(10) << "time (ms)" << "  " << std::left << std::setw(10) << "Operation" << std::right
+              << std::setw(12) << "completed"
+              << std::setw(12) << "succeeded";
+    if (window_latency)
+    {
+        std::cout << std::setw(10) << "50%"
+                  << std::setw(10) << "99%"
+                  << std::setw(10) << "99.9%"
+                  << std::setw(10) << "max";
+    }
+    std::cout << '\n';
+    for (size_t w = 0; w < result.samples.size(); ++w)
     {
-        std::vector<uint64_t> global_latencies;
-        for(auto& v : local_stats)
-            for(unsigned int i=0; i<v.times.size(); i=i+2)
-                global_latencies.push_back(std::chrono::nanoseconds(v.times[i+1]-v.times[i]).count());
+        const auto& s = result.samples[w];
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            if (s.completed[op] == 0)
+                continue;
 
-        std::sort(global_latencies.begin(), global_latencies.end());
-        auto observed = global_latencies.size();
-        std::cout << "Latencies (" << observed << " operations observed):\n"
-                  << "\tmin: " << global_latencies[0] << '\n'
-                  << "\t50%: " << global_latencies[0.5*observed] << '\n'
-                  << "\t90%: " << global_latencies[0.9*observed] << '\n'
-                  << "\t99%: " << global_latencies[0.99*observed] << '\n'
-                  << "\t99.9%: " << global_latencies[0.999*observed] << '\n'
-                  << "\t99.99%: " << global_latencies[0.9999*observed] << '\n'
-                  << "\t99.999%: " << global_latencies[0.99999*observed] << '\n'
-                  << "\tmax: " << global_latencies[observed-1] << std::endl;
+            std::cout << "\t" << std::setw(10) << (w + 1) * result.opt.sampling_ms
+                      << "  " << std::left << std::setw(10) << static_cast<operation_t>(op) << std::right
+                      << std::setw(12) << s.completed[op]
+                      << std::setw(12) << s.succeeded[op];
+            if (window_latency)
+            {
+                const auto& l = result.sample_latencies[w][op];
+                if (l.count > 0)
+                {
+                    std::cout << std::setw(10) << l.p50
+                              << std::setw(10) << l.p99
+                              << std::setw(10) << l.p999
+                              << std::setw(10) << l.max;
+                }
+                else
+                {
+                    std::cout << std::setw(10) << "-" << std::setw(10) << "-"
+                              << std::setw(10) << "-" << std::setw(10) << "-";
+                }
+            }
+            std::cout << '\n';
+        }
+    }
+
+    // Throughput (ops/s) of the windows around each move of the hot set,
+    // and how long it took to get back to 90% of the throughput before it.
+    if (!result.hot_shifts.empty())
+    {
+        std::cout << "Hotspot shifts:\n"
+                  << "\t" << std::setw(10) << "time (ms)"
+                  << std::setw(14) << "before";
+        for (size_t a = 0; a < hot_shift_result_t::WINDOWS; ++a)
+            std::cout << std::setw(14) << "after +" + std::to_string(a);
+        std::cout << std::setw(16) << "recovery (ms)" << '\n';
+        for (const auto& h : result.hot_shifts)
+        {
+            std::cout << "\t" << std::setw(10) << h.window * result.opt.sampling_ms
+                      << std::setw(14) << std::llround(h.before);
+            for (size_t a = 0; a < hot_shift_result_t::WINDOWS; ++a)
+            {
+                if (a < h.after.size())
+                    std::cout << std::setw(14) << std::llround(h.after[a]);
+                else
+                    std::cout << std::setw(14) << "-";
+            }
+            if (h.recovery_ms >= 0.0)
+                std::cout << std::setw(16) << h.recovery_ms;
+            else
+                std::cout << std::setw(16) << "-";
+            std::cout << '\n';
+        }
     }
+    std::cout << std::flush;
+
+    if (!result.has_latency)
+        return;
+
+    std::cout << "Timer: " << result.timer;
+    if (result.timer == timer_source_t::TSC)
+        std::cout << " (" << 1.0 / result.timer_ns_per_tick << " GHz)";
+    std::cout << "\n"
+              << "\tOverhead: min " << result.timer_min_overhead_ns << " ns, median "
+              << result.timer_overhead_ns << " ns"
+              << (result.opt.subtract_timer_overhead ? " (subtracted)" : "") << std::endl;
+
+    const auto& l = result.latency;
+    std::cout << "Latencies (" << l.count << " operations observed):\n"
+              << "\tmin: " << l.min << '\n'
+              << "\t50%: " << l.p50 << '\n'
+              << "\t90%: " << l.p90 << '\n'
+              << "\t99%: " << l.p99 << '\n'
+              << "\t99.9%: " << l.p999 << '\n'
+              << "\t99.99%: " << l.p9999 << '\n'
+              << "\t99.999%: " << l.p99999 << '\n'
+              << "\tmax: " << l.max << std::endl;
+
+    auto print_row = [&](const std::string& name, const latency_summary_t& h)
+    {
+        std::cout << "\t" << std::left << std::setw(16) << name << std::right
+                  << std::setw(12) << h.count
+                  << std::setw(10) << h.min
+                  << std::setw(10) << h.p50
+                  << std::setw(10) << h.p90
+                  << std::setw(10) << h.p99
+                  << std::setw(10) << h.p999
+                  << std::setw(10) << h.p9999
+                  << std::setw(10) << h.max << '\n';
+    };
+
+    std::cout << "Latency breakdown:\n"
+              << "\t" << std::left << std::setw(16) << "Operation" << std::right
+              << std::setw(12) << "count"
+              << std::setw(10) << "min"
+              << std::setw(10) << "50%"
+              << std::setw(10) << "90%"
+              << std::setw(10) << "99%"
+              << std::setw(10) << "99.9%"
+              << std::setw(10) << "99.99%"
+              << std::setw(10) << "max" << '\n';
+    for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+    {
+        if (result.op_latency[op].count == 0)
+            continue;
+
+        std::ostringstream name;
+        name << static_cast<operation_t>(op);
+
+        print_row(name.str(), result.op_latency[op]);
+        if (result.op_succeeded_latency[op].count > 0)
+            print_row("- succeeded", result.op_succeeded_latency[op]);
+        if (result.op_failed_latency[op].count > 0)
+            print_row("- failed", result.op_failed_latency[op]);
+    }
+
+    if (result.opt.rate > 0.0)
+        print_row("Service time", result.service_latency);
+    if (result.opt.batch_size > 1)
+        print_row("Batch", result.batch_latency);
+    std::cout << std::flush;
 }
 
-void benchmark_t::run_op(operation_t op, const char *key_ptr, 
+bool benchmark_t::run_op(operation_t op, const char *key_ptr,
+                         uint32_t value_size, uint32_t scan_size,
                          char *value_out, char *values_out, bool measure_latency,
-                         stats_t &stats)
+                         thread_stats_t &stats)
 {
+    bool succeeded = false;
     switch (op)
     {
     case operation_t::READ:
     {
-        auto r = tree_->find(key_ptr, key_generator_->size(), value_out);
-        ++stats.read_count;
-        if (r)
-        {
-            ++stats.success_read_count;
-        }
+        succeeded = tree_->find(key_ptr, key_generator_->size(), value_out);
         break;
     }
 
     case operation_t::INSERT:
     {
         // Generate random value
-        auto value_ptr = value_generator_.next();
-        auto r = tree_->insert(key_ptr, key_generator_->size(), value_ptr, opt_.value_size);
-        ++stats.insert_count;
-        if (r)
-        {
-            ++stats.success_insert_count;
-        }
+        auto value_ptr = value_generator_.next(value_size);
+        succeeded = tree_->insert(key_ptr, key_generator_->size(), value_ptr, value_size);
         break;
     }
 
     case operation_t::UPDATE:
     {
         // Generate random value
-        auto value_ptr = value_generator_.next();
-        auto r = tree_->update(key_ptr, key_generator_->size(), value_ptr, opt_.value_size);
-        ++stats.update_count;
-        if (r)
-        {
-            ++stats.success_update_count;
-        }
+        auto value_ptr = value_generator_.next(value_size);
+        succeeded = tree_->update(key_ptr, key_generator_->size(), value_ptr, value_size);
         break;
     }
 
     case operation_t::REMOVE:
     {
-        auto r = tree_->remove(key_ptr, key_generator_->size());
-        ++stats.remove_count;
-        if (r)
-        {
-            ++stats.success_remove_count;
-        }
+        succeeded = tree_->remove(key_ptr, key_generator_->size());
         break;
     }
 
     case operation_t::SCAN:
     {
-        auto r = tree_->scan(key_ptr, key_generator_->size(), opt_.scan_size, values_out);
-        ++stats.scan_count;
-        if (r)
-        {
-            ++stats.success_scan_count;
-        }
+        succeeded = tree_->scan(key_ptr, key_generator_->size(), scan_size, values_out);
+        break;
+    }
+
+    case operation_t::READ_MODIFY_WRITE:
+    {
+        // Both steps are issued regardless of the outcome of the read, as YCSB does
+        succeeded = tree_->find(key_ptr, key_generator_->size(), value_out);
+        auto value_ptr = value_generator_.next(value_size);
+        succeeded = tree_->update(key_ptr, key_generator_->size(), value_ptr, value_size) && succeeded;
         break;
     }
 
@@ -567,7 +1937,34 @@ void benchmark_t::run_op(operation_t op, const char *key_ptr,
         exit(0);
         break;
     }
-    ++stats.operation_count;
+    stats.record(op, succeeded);
+    return succeeded;
+}
+
+size_t benchmark_t::run_batch(operation_t op, size_t num, const char* const* keys,
+                              const char* const* values, uint32_t value_size,
+                              char* const* values_out, bool* succeeded,
+                              thread_stats_t &stats)
+{
+    size_t n = 0;
+    switch (op)
+    {
+    case operation_t::READ:
+        n = tree_->multi_find(num, keys, key_generator_->size(), values_out, succeeded);
+        break;
+
+    case operation_t::INSERT:
+        n = tree_->multi_insert(num, keys, key_generator_->size(), values, value_size, succeeded);
+        break;
+
+    default:
+        std::cout << "Error: operation cannot be batched!" << std::endl;
+        exit(0);
+        break;
+    }
+    for (size_t i = 0; i < num; ++i)
+        stats.record(op, succeeded[i]);
+    return n;
 }
 
 } // namespace PiBench
@@ -587,11 +1984,143 @@ std::ostream& operator<<(std::ostream& os, const PiBench::distribution_t& dist)
     case PiBench::distribution_t::ZIPFIAN:
         return os << "ZIPFIAN";
         break;
+    case PiBench::distribution_t::LATEST:
+        return os << "LATEST";
+        break;
+    case PiBench::distribution_t::SCRAMBLED_ZIPFIAN:
+        return os << "SCRAMBLED_ZIPFIAN";
+        break;
+    case PiBench::distribution_t::CLUSTERED_ZIPFIAN:
+        return os << "CLUSTERED_ZIPFIAN";
+        break;
+    case PiBench::distribution_t::HOTSPOT:
+        return os << "HOTSPOT";
+        break;
     default:
         return os << static_cast<uint8_t>(dist);
     }
 }
 
+std::ostream& operator<<(std::ostream& os, const PiBench::operation_t& op)
+{
+    switch (op)
+    {
+    case PiBench::operation_t::READ:
+        return os << "Read";
+    case PiBench::operation_t::INSERT:
+        return os << "Insert";
+    case PiBench::operation_t::UPDATE:
+        return os << "Update";
+    case PiBench::operation_t::REMOVE:
+        return os << "Remove";
+    case PiBench::operation_t::SCAN:
+        return os << "Scan";
+    case PiBench::operation_t::READ_MODIFY_WRITE:
+        return os << "RMW";
+    default:
+        return os << static_cast<uint32_t>(op);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::timer_source_t& source)
+{
+    switch (source)
+    {
+    case PiBench::timer_source_t::CHRONO:
+        return os << "CHRONO";
+    case PiBench::timer_source_t::TSC:
+        return os << "TSC";
+    default:
+        return os << static_cast<uint32_t>(source);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::hot_shift_t& shift)
+{
+    switch (shift)
+    {
+    case PiBench::hot_shift_t::NONE:
+        return os << "NONE";
+    case PiBench::hot_shift_t::SLIDE:
+        return os << "SLIDE";
+    case PiBench::hot_shift_t::JUMP:
+        return os << "JUMP";
+    default:
+        return os << static_cast<uint32_t>(shift);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::arrival_t& arrival)
+{
+    switch (arrival)
+    {
+    case PiBench::arrival_t::CONSTANT:
+        return os << "CONSTANT";
+    case PiBench::arrival_t::POISSON:
+        return os << "POISSON";
+    default:
+        return os << static_cast<uint32_t>(arrival);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::scan_length_t& length)
+{
+    switch (length)
+    {
+    case PiBench::scan_length_t::CONSTANT:
+        return os << "CONSTANT";
+    case PiBench::scan_length_t::UNIFORM:
+        return os << "UNIFORM";
+    default:
+        return os << static_cast<uint32_t>(length);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::load_mode_t& mode)
+{
+    switch (mode)
+    {
+    case PiBench::load_mode_t::INSERT:
+        return os << "INSERT";
+    case PiBench::load_mode_t::BULK:
+        return os << "BULK";
+    default:
+        return os << static_cast<uint32_t>(mode);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::key_order_t& order)
+{
+    switch (order)
+    {
+    case PiBench::key_order_t::HASHED:
+        return os << "HASHED";
+    case PiBench::key_order_t::SEQUENTIAL:
+        return os << "SEQUENTIAL";
+    case PiBench::key_order_t::REVERSE:
+        return os << "REVERSE";
+    case PiBench::key_order_t::KSORTED:
+        return os << "KSORTED";
+    case PiBench::key_order_t::MONOTONIC:
+        return os << "MONOTONIC";
+    default:
+        return os << static_cast<uint32_t>(order);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::key_encoding_t& encoding)
+{
+    switch (encoding)
+    {
+    case PiBench::key_encoding_t::NATIVE:
+        return os << "NATIVE";
+    case PiBench::key_encoding_t::BIGENDIAN:
+        return os << "BIGENDIAN";
+    default:
+        return os << static_cast<uint32_t>(encoding);
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const PiBench::options_t& opt)
 {
     os << "Benchmark Options:"
@@ -601,23 +2130,79 @@ std::ostream& operator<<(std::ostream& os, const PiBench::options_t& opt)
        << "\t# Threads: " << opt.num_threads << "\n"
        << (opt.bm_mode == PiBench::mode_t::Operation ? "\t# Operations: " : "\tDuration (s): ") << (opt.bm_mode == PiBench::mode_t::Operation ? opt.num_ops : opt.seconds) << "\n"
        << "\tSampling: " << opt.sampling_ms << " ms\n"
+       << "\tAffinity: " << opt.affinity;
+    if (opt.affinity == PiBench::affinity_t::LIST)
+    {
+        os << " (";
+        for (size_t i = 0; i < opt.cpus.size(); ++i)
+            os << (i ? "," : "") << opt.cpus[i];
+        os << ")";
+    }
+    os << "\n"
+       << "\tMemory policy: load " << opt.load_mempolicy << ", run " << opt.run_mempolicy;
+    if (!opt.mempolicy_nodes.empty())
+    {
+        os << " (nodes ";
+        for (size_t i = 0; i < opt.mempolicy_nodes.size(); ++i)
+            os << (i ? "," : "") << opt.mempolicy_nodes[i];
+        os << ")";
+    }
+    os << "\n";
+    if (opt.load_mode == PiBench::load_mode_t::BULK)
+    {
+        os << "\tLoad mode: " << opt.load_mode;
+        if (opt.load_chunk > 0)
+            os << " (chunks of " << opt.load_chunk << " records)";
+        os << "\n";
+    }
+    if (opt.rate > 0.0)
+        os << "\tRate: " << opt.rate << " ops/s (open-loop, " << opt.arrival << " arrivals)\n";
+    else
+        os << "\tRate: unlimited (closed-loop)\n";
+    if (opt.pregenerate)
+        os << "\tRequests: pre-generated\n";
+    else if (!opt.record_trace.empty())
+        os << "\tRequests: recorded to " << opt.record_trace << "\n";
+    else if (!opt.replay_trace.empty())
+        os << "\tRequests: replayed from " << opt.replay_trace << "\n";
+    if (opt.batch_size > 1)
+        os << "\tBatch size: " << opt.batch_size << " (reads and inserts)\n";
+    if (opt.interleave > 1)
+        os << "\tInterleave: " << opt.interleave << " lookups in flight\n";
+    os
        << "\tLatency: " << opt.latency_sampling << "\n"
+       << "\tLatency timer: " << opt.latency_timer
+       << (opt.subtract_timer_overhead ? " (overhead subtracted)" : "") << "\n"
        << "\tKey prefix: " << opt.key_prefix << "\n"
        << "\tKey size: " << opt.key_size << "\n"
+       << "\tKey order: " << opt.key_order
+       << (opt.key_order == PiBench::key_order_t::KSORTED ? " (max displacement " + std::to_string(opt.key_displacement) + ")" : "") << "\n"
+       << "\tKey encoding: " << opt.key_encoding << "\n"
        << "\tValue size: " << opt.value_size << "\n"
        << "\tRandom seed: " << opt.rnd_seed << "\n"
-       << "\tKey distribution: " << opt.key_distribution
-       << (opt.key_distribution == PiBench::distribution_t::SELFSIMILAR || opt.key_distribution == PiBench::distribution_t::ZIPFIAN
-               ? "(" + std::to_string(opt.key_skew) + ")"
-               : "")
-       << "\n"
-       << "\tScan size: " << opt.scan_size << "\n"
+       << "\tKey distribution: " << opt.key_distribution;
+    if (opt.key_distribution == PiBench::distribution_t::HOTSPOT)
+    {
+        os << " (" << opt.hot_ops * 100 << "% of operations on " << opt.hot_set * 100 << "% of keys";
+        if (opt.hot_shift == PiBench::hot_shift_t::SLIDE)
+            os << ", sliding by " << opt.hot_step * 100 << "% of keys every " << opt.hot_shift_ms << " ms";
+        else if (opt.hot_shift == PiBench::hot_shift_t::JUMP)
+            os << ", jumping every " << opt.hot_shift_ms << " ms";
+        os << ")";
+    }
+    else if (opt.key_distribution != PiBench::distribution_t::UNIFORM)
+        os << "(" << std::to_string(opt.key_skew) << ")";
+    os << "\n"
+       << "\tScan size: " << opt.scan_size
+       << (opt.scan_length == PiBench::scan_length_t::UNIFORM ? " (maximum, uniform)" : "") << "\n"
        << "\tOperations ratio:\n"
        << "\t\tRead: " << opt.read_ratio << "\n"
        << "\t\tInsert: " << opt.insert_ratio << "\n"
        << "\t\tUpdate: " << opt.update_ratio << "\n"
        << "\t\tDelete: " << opt.remove_ratio << "\n"
        << "\t\tScan: " << opt.scan_ratio;
+    if (opt.rmw_ratio > 0.0)
+        os << "\n\t\tRead-modify-write: " << opt.rmw_ratio;
     return os;
 }
 } // namespace std
@@ -0,0 +1,340 @@
+#include "cpu_topology.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace PiBench
+{
+
+namespace
+{
+
+bool read_uint(const std::string& path, uint32_t& value)
+{
+    std::ifstream in(path);
+    return static_cast<bool>(in >> value);
+}
+
+bool read_line(const std::string& path, std::string& line)
+{
+    std::ifstream in(path);
+    return static_cast<bool>(std::getline(in, line));
+}
+
+} // namespace
+
+bool parse_affinity(std::string name, affinity_t& affinity)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("none") == 0)
+        affinity = affinity_t::NONE;
+    else if (name.compare("compact") == 0)
+        affinity = affinity_t::COMPACT;
+    else if (name.compare("scatter") == 0)
+        affinity = affinity_t::SCATTER;
+    else if (name.compare("cores") == 0)
+        affinity = affinity_t::CORES;
+    else if (name.compare("list") == 0)
+        affinity = affinity_t::LIST;
+    else
+        return false;
+    return true;
+}
+
+bool parse_mempolicy(std::string name, mempolicy_t& policy)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("default") == 0)
+        policy = mempolicy_t::DEFAULT;
+    else if (name.compare("local") == 0)
+        policy = mempolicy_t::LOCAL;
+    else if (name.compare("interleave") == 0)
+        policy = mempolicy_t::INTERLEAVE;
+    else if (name.compare("bind") == 0)
+        policy = mempolicy_t::BIND;
+    else
+        return false;
+    return true;
+}
+
+bool parse_cpu_list(const std::string& list, std::vector<uint32_t>& cpus)
+{
+    cpus.clear();
+    size_t pos = 0;
+    while (pos <= list.size())
+    {
+        auto end = list.find(',', pos);
+        if (end == std::string::npos)
+            end = list.size();
+
+        auto range = list.substr(pos, end - pos);
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty() || range.find_first_not_of("0123456789-") != std::string::npos)
+            return false;
+
+        auto dash = range.find('-');
+        try
+        {
+            uint32_t first = std::stoul(range.substr(0, dash));
+            uint32_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            if (last < first)
+                return false;
+            for (uint32_t cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        catch (const std::logic_error&)
+        {
+            return false;
+        }
+
+        pos = end + 1;
+    }
+    return !cpus.empty();
+}
+
+std::vector<cpu_t> read_topology()
+{
+    const std::string sysfs = "/sys/devices/system/";
+
+    std::vector<uint32_t> online;
+    std::string line;
+    if (!read_line(sysfs + "cpu/online", line) || !parse_cpu_list(line, online))
+    {
+        online.clear();
+        for (uint32_t i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+            online.push_back(i);
+    }
+
+    std::vector<cpu_t> cpus;
+    for (auto id : online)
+    {
+        cpu_t cpu;
+        cpu.id = id;
+        cpu.core = id;
+        auto topology = sysfs + "cpu/cpu" + std::to_string(id) + "/topology/";
+        read_uint(topology + "core_id", cpu.core);
+        read_uint(topology + "physical_package_id", cpu.socket);
+        cpus.push_back(cpu);
+    }
+
+    // NUMA nodes list their CPUs
+    if (auto dir = opendir((sysfs + "node").c_str()))
+    {
+        while (auto entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4
+                || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+
+            std::vector<uint32_t> node_cpus;
+            if (!read_line(sysfs + "node/" + name + "/cpulist", line) || !parse_cpu_list(line, node_cpus))
+                continue;
+
+            uint32_t node = std::stoul(name.substr(4));
+            for (auto& cpu : cpus)
+                if (std::find(node_cpus.begin(), node_cpus.end(), cpu.id) != node_cpus.end())
+                    cpu.node = node;
+        }
+        closedir(dir);
+    }
+
+    // Rank SMT siblings within their core
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> siblings;
+    for (auto& cpu : cpus)
+        cpu.sibling = siblings[{cpu.socket, cpu.core}]++;
+
+    return cpus;
+}
+
+std::vector<uint32_t> numa_nodes(const std::vector<cpu_t>& topology)
+{
+    std::set<uint32_t> nodes;
+    for (auto& cpu : topology)
+        nodes.insert(cpu.node);
+    return std::vector<uint32_t>(nodes.begin(), nodes.end());
+}
+
+std::vector<uint32_t> place_threads(const std::vector<cpu_t>& topology, affinity_t policy,
+                                    uint32_t num_threads, const std::vector<uint32_t>& cpu_list)
+{
+    std::vector<uint32_t> order;
+    if (policy == affinity_t::LIST)
+    {
+        order = cpu_list;
+    }
+    else
+    {
+        // Rank of each core within its socket, so sockets can be interleaved
+        // even if core ids are sparse.
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> core_rank;
+        for (auto& cpu : topology)
+            core_rank.emplace(std::make_pair(cpu.socket, cpu.core), 0);
+        std::map<uint32_t, uint32_t> cores_per_socket;
+        for (auto& c : core_rank)
+            c.second = cores_per_socket[c.first.first]++;
+
+        auto key = [&](const cpu_t& cpu)
+        {
+            auto rank = core_rank[{cpu.socket, cpu.core}];
+            switch (policy)
+            {
+            case affinity_t::COMPACT:
+                return std::make_tuple(cpu.socket, rank, cpu.sibling, cpu.id);
+            case affinity_t::SCATTER:
+                return std::make_tuple(cpu.sibling, rank, cpu.socket, cpu.id);
+            default: // CORES
+                return std::make_tuple(cpu.sibling, cpu.socket, rank, cpu.id);
+            }
+        };
+
+        auto sorted = topology;
+        std::sort(sorted.begin(), sorted.end(),
+                  [&](const cpu_t& a, const cpu_t& b) { return key(a) < key(b); });
+        for (auto& cpu : sorted)
+            order.push_back(cpu.id);
+    }
+
+    std::vector<uint32_t> placement;
+    if (order.empty())
+        return placement;
+
+    for (uint32_t i = 0; i < num_threads; ++i)
+        placement.push_back(order[i % order.size()]);
+    return placement;
+}
+
+int pick_monitor_cpu(const std::vector<cpu_t>& topology, const std::vector<uint32_t>& placement)
+{
+    std::set<uint32_t> used(placement.begin(), placement.end());
+    std::set<std::pair<uint32_t, uint32_t>> busy_cores;
+    for (auto& cpu : topology)
+        if (used.count(cpu.id))
+            busy_cores.insert({cpu.socket, cpu.core});
+
+    int sibling = -1;
+    for (auto it = topology.rbegin(); it != topology.rend(); ++it)
+    {
+        if (used.count(it->id))
+            continue;
+        if (!busy_cores.count({it->socket, it->core}))
+            return it->id;
+        if (sibling < 0)
+            sibling = it->id;
+    }
+    return sibling;
+}
+
+bool pin_thread(uint32_t cpu)
+{
+    return pin_thread(std::vector<uint32_t>{cpu});
+}
+
+bool pin_thread(const std::vector<uint32_t>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+int current_cpu()
+{
+    return sched_getcpu();
+}
+
+bool apply_mempolicy(mempolicy_t policy, const std::vector<uint32_t>& nodes)
+{
+#ifdef SYS_set_mempolicy
+    // Modes as defined in <linux/mempolicy.h>, called directly so that
+    // libnuma is not required.
+    static constexpr int MPOL_DEFAULT_ = 0;
+    static constexpr int MPOL_BIND_ = 2;
+    static constexpr int MPOL_INTERLEAVE_ = 3;
+    static constexpr int MPOL_LOCAL_ = 4;
+    static constexpr size_t MAX_NODES = 1024;
+    static constexpr size_t BITS = 8 * sizeof(unsigned long);
+
+    unsigned long mask[MAX_NODES / BITS] = {};
+    for (auto node : nodes)
+    {
+        if (node >= MAX_NODES)
+            return false;
+        mask[node / BITS] |= 1ul << (node % BITS);
+    }
+
+    long r;
+    switch (policy)
+    {
+    case mempolicy_t::DEFAULT:
+        r = syscall(SYS_set_mempolicy, MPOL_DEFAULT_, nullptr, 0);
+        break;
+    case mempolicy_t::LOCAL:
+        r = syscall(SYS_set_mempolicy, MPOL_LOCAL_, nullptr, 0);
+        break;
+    case mempolicy_t::INTERLEAVE:
+    case mempolicy_t::BIND:
+        // The kernel expects one more than the number of bits in the mask
+        r = syscall(SYS_set_mempolicy, policy == mempolicy_t::BIND ? MPOL_BIND_ : MPOL_INTERLEAVE_,
+                    mask, MAX_NODES + 1);
+        break;
+    default:
+        return false;
+    }
+    return r == 0;
+#else
+    return policy == mempolicy_t::DEFAULT;
+#endif
+}
+
+} // namespace PiBench
+
+namespace std
+{
+std::ostream& operator<<(std::ostream& os, const PiBench::affinity_t& affinity)
+{
+    switch (affinity)
+    {
+    case PiBench::affinity_t::NONE:
+        return os << "NONE";
+    case PiBench::affinity_t::COMPACT:
+        return os << "COMPACT";
+    case PiBench::affinity_t::SCATTER:
+        return os << "SCATTER";
+    case PiBench::affinity_t::CORES:
+        return os << "CORES";
+    case PiBench::affinity_t::LIST:
+        return os << "LIST";
+    default:
+        return os << static_cast<int>(affinity);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const PiBench::mempolicy_t& policy)
+{
+    switch (policy)
+    {
+    case PiBench::mempolicy_t::DEFAULT:
+        return os << "DEFAULT";
+    case PiBench::mempolicy_t::LOCAL:
+        return os << "LOCAL";
+    case PiBench::mempolicy_t::INTERLEAVE:
+        return os << "INTERLEAVE";
+    case PiBench::mempolicy_t::BIND:
+        return os << "BIND";
+    default:
+        return os << static_cast<int>(policy);
+    }
+}
+} // namespace std
@@ -1,12 +1,18 @@
 #include "key_generator.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace PiBench
 {
 
-thread_local std::default_random_engine key_generator_t::generator_;
+thread_local xoshiro256pp_engine key_generator_t::generator_;
 thread_local uint32_t key_generator_t::seed_;
 thread_local char key_generator_t::buf_[KEY_MAX];
+thread_local char key_generator_t::batch_buf_[BATCH_SIZE * KEY_MAX];
+thread_local uint32_t key_generator_t::batch_pos_ = 0;
+thread_local uint32_t key_generator_t::batch_count_ = 0;
 thread_local uint64_t key_generator_t::current_id_ = 1;
 
 key_generator_t::key_generator_t(size_t N, size_t size, const std::string& prefix)
@@ -35,34 +41,127 @@ const char* key_generator_t::next(bool in_sequence)
 
 const char* key_generator_t::hash_id(uint64_t id)
 {
-    char* ptr = &buf_[prefix_.size()];
+    store_id(order_id(id), &buf_[prefix_.size()], size_, encoding_);
+    return buf_;
+}
 
-    uint64_t hashed_id = utils::multiplicative_hash<uint64_t>(id);
+void key_generator_t::hash_ids(const uint64_t* ids, size_t count, char* out)
+{
+    if (prefix_.empty() && size_ == sizeof(uint64_t) && order_ == key_order_t::HASHED
+        && encoding_ == key_encoding_t::NATIVE)
+    {
+        hash_ids_u64(ids, count, out);
+        return;
+    }
 
-    if (size_ < sizeof(hashed_id))
+    const size_t key_size = size();
+    for (size_t i = 0; i < count; ++i)
     {
-        // We want key smaller than 8 Bytes, so discard higher bits.
-        auto bits_to_shift = (sizeof(hashed_id) - size_) << 3;
+        char* key = out + i * key_size;
+        memcpy(key, prefix_.data(), prefix_.size());
+        store_id(order_id(ids[i]), key + prefix_.size(), size_, encoding_);
+    }
+}
 
-        // Discard high order bits
-        if (utils::is_big_endian())
-        {
-            hashed_id >>= bits_to_shift;
-            hashed_id <<= bits_to_shift;
-        }
-        else
-        {
-            hashed_id <<= bits_to_shift;
-            hashed_id >>= bits_to_shift;
-        }
+void key_generator_t::hash_ids_u64(const uint64_t* ids, size_t count, char* out) noexcept
+{
+    #pragma omp simd
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t hashed_id = utils::multiplicative_hash<uint64_t>(ids[i]);
+        memcpy(out + i * sizeof(uint64_t), &hashed_id, sizeof(uint64_t));
+    }
+}
+
+void key_generator_t::fill_batch()
+{
+    uint64_t ids[BATCH_SIZE];
+    next_ids(ids, BATCH_SIZE);
+    hash_ids(ids, BATCH_SIZE, batch_buf_);
+    batch_pos_ = 0;
+    batch_count_ = BATCH_SIZE;
+}
+
+uint64_t key_generator_t::order_id(uint64_t id) const noexcept
+{
+    switch (order_)
+    {
+    case key_order_t::SEQUENTIAL:
+        return id;
+
+    case key_order_t::REVERSE:
+        // Keys shorter than 8 Bytes keep the low bits, which still decrease
+        return std::numeric_limits<uint64_t>::max() - id;
+
+    case key_order_t::KSORTED:
+    {
+        // Permute ids within blocks of 'displacement_' consecutive ids. The
+        // multiplier is a prime larger than any block, so it is coprime to
+        // the block size and the permutation is a bijection.
+        static constexpr uint64_t PRIME = 2654435761u;
+        uint64_t block = (id - 1) / displacement_;
+        uint64_t offset = (id - 1) % displacement_;
+        return block * displacement_ + (offset * PRIME) % displacement_ + 1;
+    }
 
-        memcpy(ptr, &hashed_id, size_); // TODO: check if must change to fit endianess
+    case key_order_t::MONOTONIC:
+    {
+        // Every stream gets an equal share of the values keys can hold
+        uint64_t range = size_ >= sizeof(uint64_t) ? std::numeric_limits<uint64_t>::max() / streams_
+                                                   : (1ull << (size_ * 8)) / streams_;
+        return ((id - 1) % streams_) * range + (id - 1) / streams_ + 1;
+    }
+
+    case key_order_t::HASHED:
+    default:
+        // Keys shorter than 8 Bytes keep only the low bits, so scramble ids
+        // with a permutation of exactly that many bits to avoid collisions.
+        if (size_ < sizeof(uint64_t))
+            return utils::feistel_permute(id & ((1ull << (size_ * 8)) - 1), size_ * 8);
+        return utils::multiplicative_hash<uint64_t>(id);
+    }
+}
+
+uint64_t key_generator_t::key_rank_id(uint64_t rank) const noexcept
+{
+    if (order_ != key_order_t::MONOTONIC || streams_ == 1)
+        return rank;
+
+    // Streams are laid out one after the other in key order, and stream s
+    // holds ids s+1, s+1+streams_, ... The few ids past the last complete
+    // round keep their rank.
+    uint64_t per_stream = N_ / streams_;
+    uint64_t r = rank - 1;
+    if (r >= per_stream * streams_)
+        return rank;
+    return 1 + (r % per_stream) * streams_ + r / per_stream;
+}
+
+void key_generator_t::store_id(uint64_t hashed_id, char* ptr, size_t size, key_encoding_t encoding) noexcept
+{
+    if (encoding == key_encoding_t::BIGENDIAN)
+    {
+        // Most significant Byte first, keys wider than 8 Bytes are padded
+        // with leading zeroes, which keeps them in numeric order.
+        size_t bytes = std::min(size, sizeof(hashed_id));
+        memset(ptr, 0, size - bytes);
+        for (size_t i = 0; i < bytes; ++i)
+            ptr[size - 1 - i] = static_cast<char>(hashed_id >> (8 * i));
+        return;
+    }
+
+    if (size < sizeof(hashed_id))
+    {
+        // We want key smaller than 8 Bytes, so discard higher bits. The low
+        // order bytes come last on big endian machines.
+        auto offset = utils::is_big_endian() ? sizeof(hashed_id) - size : 0;
+        memcpy(ptr, reinterpret_cast<const char*>(&hashed_id) + offset, size);
     }
     else
     {
         // TODO: change this, otherwise zeroes act as prefix
         // We want key of at least 8 Bytes, check if we must prepend zeroes
-        auto bytes_to_prepend = size_ - sizeof(hashed_id);
+        auto bytes_to_prepend = size - sizeof(hashed_id);
         if (bytes_to_prepend > 0)
         {
             memset(ptr, 0, bytes_to_prepend);
@@ -70,6 +169,5 @@ const char* key_generator_t::hash_id(uint64_t id)
         }
         memcpy(ptr, &hashed_id, sizeof(hashed_id));
     }
-    return buf_;
 }
 } // namespace PiBench
@@ -0,0 +1,77 @@
+#include "latency_timer.hpp"
+#include "histogram.hpp"
+
+#include <memory>
+#include <thread>
+
+#if PIBENCH_HAS_TSC
+#include <cpuid.h>
+#endif
+
+namespace PiBench
+{
+
+latency_timer_t::latency_timer_t(timer_source_t source)
+    : source_(source),
+      ns_per_tick_(1.0),
+      overhead_(0),
+      min_overhead_(0)
+{
+    if (source_ == timer_source_t::TSC)
+        calibrate();
+
+    measure_overhead();
+}
+
+bool latency_timer_t::tsc_supported() noexcept
+{
+#if PIBENCH_HAS_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+        return false;
+
+    // CPUID.80000007H:EDX[8] indicates invariant TSC
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+void latency_timer_t::calibrate()
+{
+    using clock = std::chrono::steady_clock;
+
+    // Take the best of a few short rounds to filter out preemption.
+    double best = 0.0;
+    for (int round = 0; round < 5; ++round)
+    {
+        auto t0 = clock::now();
+        auto c0 = start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto c1 = stop();
+        auto t1 = clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        double ratio = ns / (c1 - c0);
+        if (best == 0.0 || ratio < best)
+            best = ratio;
+    }
+    ns_per_tick_ = best;
+}
+
+void latency_timer_t::measure_overhead()
+{
+    static constexpr size_t ROUNDS = 100000;
+
+    auto h = std::make_unique<histogram_t>();
+    for (size_t i = 0; i < ROUNDS; ++i)
+    {
+        auto t0 = start();
+        auto t1 = stop();
+        h->record(t1 - t0);
+    }
+    overhead_ = h->percentile(0.5);
+    min_overhead_ = h->min();
+}
+} // namespace PiBench
@@ -1,22 +1,258 @@
 #include "tree_api.hpp"
 #include "benchmark.hpp"
 #include "library_loader.hpp"
+#include "result_writer.hpp"
+#include "trace.hpp"
+#include "workload_file.hpp"
 #include "cxxopts.hpp"
 
 #include <iostream>
 #include <algorithm>
 #include <cstdlib>
 #include <cerrno>
+#include <cmath>
+#include <fstream>
 
 #include <dlfcn.h>
 
 using namespace PiBench;
 
+/**
+ * @brief Check that options are consistent.
+ *
+ * @param opt
+ * @return true if options are valid.
+ * @return false otherwise, after printing the reason.
+ */
+static bool sanitize(const options_t& opt)
+{
+    if(opt.key_prefix.size() + opt.key_size > key_generator_t::KEY_MAX)
+    {
+        std::cout << "Total key size cannot be greater than " << key_generator_t::KEY_MAX
+            << ", but is " << opt.key_prefix.size() + opt.key_size << std::endl;
+        return false;
+    }
+
+    if(opt.key_size < sizeof(uint64_t))
+    {
+        // Records loaded plus (when known) the records inserted by the run
+        uint64_t keys = opt.num_records;
+        if(opt.bm_mode == PiBench::mode_t::Operation)
+            keys += static_cast<uint64_t>(std::ceil(opt.num_ops * opt.insert_ratio));
+        uint64_t keyspace = 1ull << (opt.key_size * 8);
+        if(keys > keyspace)
+        {
+            std::cout << "Key size of " << opt.key_size << " Bytes only fits " << keyspace
+                << " unique keys, but " << keys << " records are needed." << std::endl;
+            return false;
+        }
+    }
+
+    if(opt.num_threads < 1)
+    {
+        std::cout << "Number of threads must be at least 1." << std::endl;
+        return false;
+    }
+
+    if(!(opt.sampling_ms >= benchmark_t::MIN_SAMPLING_MS))
+    {
+        std::cout << "Sampling window must be at least " << benchmark_t::MIN_SAMPLING_MS << " ms, but is " << opt.sampling_ms << std::endl;
+        return false;
+    }
+
+    if(opt.key_order == key_order_t::KSORTED && (opt.key_displacement < 1 || opt.key_displacement > (1ull << 31)))
+    {
+        std::cout << "Key displacement must be in the range [1," << (1ull << 31) << "], but is " << opt.key_displacement << std::endl;
+        return false;
+    }
+
+    if(opt.value_size > value_generator_t::VALUE_MAX)
+    {
+        std::cout << "Total value size cannot be greater than " << value_generator_t::VALUE_MAX
+            << ", but is " << opt.value_size << std::endl;
+        return false;
+    }
+
+    auto sum = opt.read_ratio+opt.insert_ratio+opt.update_ratio+opt.remove_ratio+opt.scan_ratio+opt.rmw_ratio;
+    if (std::abs(sum - 1.0) > 1e-6)
+    {
+        std::cout << "Sum of ratios should be 1.0 but is " << sum << std::endl;
+        return false;
+    }
+
+    if(opt.scan_size < 1 || opt.scan_size > benchmark_t::MAX_SCAN)
+    {
+        std::cout << "Scan size must be in the range [1," << value_generator_t::VALUE_MAX
+            << "], but is " << opt.scan_size << std::endl;
+        return false;
+    }
+
+    if(opt.key_distribution == distribution_t::SELFSIMILAR && (opt.key_skew < 0.0 || opt.key_skew > 0.5))
+    {
+        std::cout << "Skew factor must be in the range [0 , 0.5]." << std::endl;
+        return false;
+    }
+
+    if((opt.key_distribution == distribution_t::ZIPFIAN || opt.key_distribution == distribution_t::LATEST
+        || opt.key_distribution == distribution_t::SCRAMBLED_ZIPFIAN || opt.key_distribution == distribution_t::CLUSTERED_ZIPFIAN)
+        && !(opt.key_skew >= 0.0))
+    {
+        std::cout << "Skew factor must be at least 0.0." << std::endl;
+        return false;
+    }
+
+    if(opt.key_distribution == distribution_t::CLUSTERED_ZIPFIAN && opt.key_order == key_order_t::HASHED)
+    {
+        std::cout << "Clustered zipfian distribution requires ordered keys (key order other than hashed)." << std::endl;
+        return false;
+    }
+
+    if(opt.key_distribution == distribution_t::HOTSPOT)
+    {
+        if(!(opt.hot_set > 0.0 && opt.hot_set <= 1.0))
+        {
+            std::cout << "Hot set must be in the range (0.0 , 1.0], but is " << opt.hot_set << std::endl;
+            return false;
+        }
+
+        if(!(opt.hot_ops >= 0.0 && opt.hot_ops <= 1.0))
+        {
+            std::cout << "Hot operations must be in the range [0.0 , 1.0], but is " << opt.hot_ops << std::endl;
+            return false;
+        }
+
+        if(opt.hot_shift != hot_shift_t::NONE && !(opt.hot_shift_ms > 0.0))
+        {
+            std::cout << "Hot set shift interval must be greater than 0, but is " << opt.hot_shift_ms << std::endl;
+            return false;
+        }
+
+        if(opt.hot_shift == hot_shift_t::SLIDE && !(opt.hot_step > 0.0 && opt.hot_step <= 1.0))
+        {
+            std::cout << "Hot set step must be in the range (0.0 , 1.0], but is " << opt.hot_step << std::endl;
+            return false;
+        }
+
+        if(opt.hot_shift != hot_shift_t::NONE && opt.pregenerate)
+        {
+            std::cout << "Moving the hot set requires generating requests during the run (no pregenerate)." << std::endl;
+            return false;
+        }
+    }
+
+    if(opt.load_mode == load_mode_t::BULK && opt.key_encoding != key_encoding_t::BIGENDIAN)
+    {
+        std::cout << "Bulk loading requires big-endian keys (--key_encoding=bigendian), "
+            << "so the records sorted in memcmp order are sorted numerically too." << std::endl;
+        return false;
+    }
+
+    if((opt.latency_sampling < 0.0 || opt.latency_sampling > 1.0))
+    {
+        std::cout << "Latency sampling must be in the range [0.0 , 1.0]." << std::endl;
+        return false;
+    }
+
+    if(opt.rate < 0.0)
+    {
+        std::cout << "Rate must be positive (or 0 for closed-loop)." << std::endl;
+        return false;
+    }
+
+    if(opt.pregenerate && opt.bm_mode != PiBench::mode_t::Operation)
+    {
+        std::cout << "Pre-generating requests requires operation mode." << std::endl;
+        return false;
+    }
+
+    if(opt.batch_size < 1 || opt.batch_size > benchmark_t::MAX_BATCH)
+    {
+        std::cout << "Batch size must be in the range [1," << benchmark_t::MAX_BATCH << "], but is " << opt.batch_size << std::endl;
+        return false;
+    }
+
+    if(opt.batch_size > 1 && opt.rate > 0.0)
+    {
+        std::cout << "Batching cannot be combined with open-loop mode." << std::endl;
+        return false;
+    }
+
+    if(opt.interleave < 1 || opt.interleave > benchmark_t::MAX_INTERLEAVE)
+    {
+        std::cout << "Interleave must be in the range [1," << benchmark_t::MAX_INTERLEAVE << "], but is " << opt.interleave << std::endl;
+        return false;
+    }
+
+    if(opt.interleave > 1 && (opt.batch_size > 1 || opt.rate > 0.0))
+    {
+        std::cout << "Interleaving cannot be combined with batching or open-loop mode." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check options related to traces, and size the run to the trace
+ * being replayed.
+ *
+ * @param opt
+ * @return true if options are valid.
+ * @return false otherwise, after printing the reason.
+ */
+static bool prepare_trace(options_t& opt)
+{
+    if(opt.record_trace.empty() && opt.replay_trace.empty())
+        return true;
+
+    if(!opt.record_trace.empty() && !opt.replay_trace.empty())
+    {
+        std::cout << "Cannot record and replay a trace at the same time." << std::endl;
+        return false;
+    }
+
+    if(opt.pregenerate)
+    {
+        std::cout << "Pre-generating requests cannot be combined with traces." << std::endl;
+        return false;
+    }
+
+    if(opt.bm_mode != PiBench::mode_t::Operation)
+    {
+        std::cout << "Recording or replaying a trace requires operation mode." << std::endl;
+        return false;
+    }
+
+    if(!opt.replay_trace.empty())
+    {
+        try
+        {
+            trace_reader_t trace(opt.replay_trace);
+            if(trace.key_size() != opt.key_prefix.size() + opt.key_size)
+            {
+                std::cout << "Trace has keys of " << trace.key_size() << " Bytes, but total key size is "
+                    << opt.key_prefix.size() + opt.key_size << "." << std::endl;
+                return false;
+            }
+            opt.num_ops = trace.size();
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cout << "Error: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     // Parse command line arguments
     options_t opt;
     tree_options_t tree_opt;
+    std::string workload_file;
+    output_format_t output_format = output_format_t::TEXT;
+    std::string output_file;
     try
     {
         cxxopts::Options options("PiBench", "Benchmark framework for persistent indexes.");
@@ -31,24 +267,55 @@ int main(int argc, char** argv)
             ("t,threads", "Number of threads to use", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.num_threads)))
             ("f,key_prefix", "Prefix string prepended to every key", cxxopts::value<std::string>()->default_value("\"" + opt.key_prefix + "\""))
             ("k,key_size", "Size of keys in Bytes (without prefix)", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.key_size)))
+            ("key_order", "Order of inserted keys [hashed | sequential | reverse | ksorted | monotonic (per thread)]", cxxopts::value<std::string>()->default_value("hashed"))
+            ("key_displacement", "Maximum displacement of keys in ksorted order", cxxopts::value<uint64_t>()->default_value(std::to_string(opt.key_displacement)))
+            ("key_encoding", "Byte order of ids in keys [native | bigendian (memcmp order is numeric order)]", cxxopts::value<std::string>()->default_value("native"))
             ("v,value_size", "Size of values in Bytes", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.value_size)))
             ("r,read_ratio", "Ratio of read operations", cxxopts::value<float>()->default_value(std::to_string(opt.read_ratio)))
             ("i,insert_ratio", "Ratio of insert operations", cxxopts::value<float>()->default_value(std::to_string(opt.insert_ratio)))
             ("u,update_ratio", "Ratio of update operations", cxxopts::value<float>()->default_value(std::to_string(opt.update_ratio)))
             ("d,remove_ratio", "Ratio of remove operations", cxxopts::value<float>()->default_value(std::to_string(opt.remove_ratio)))
             ("s,scan_ratio", "Ratio of scan operations", cxxopts::value<float>()->default_value(std::to_string(opt.scan_ratio)))
+            ("w,rmw_ratio", "Ratio of read-modify-write operations", cxxopts::value<float>()->default_value(std::to_string(opt.rmw_ratio)))
             ("scan_size", "Number of records to be scanned.", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.scan_size)))
-            ("sampling_ms", "Sampling window in milliseconds", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.sampling_ms)))
-            ("distribution", "Key distribution to use", cxxopts::value<std::string>()->default_value("UNIFORM"))
+            ("scan_length", "Distribution of scan sizes [constant | uniform (1 to scan_size)]", cxxopts::value<std::string>()->default_value("constant"))
+            ("sampling_ms", "Sampling window in milliseconds", cxxopts::value<double>()->default_value(std::to_string(opt.sampling_ms)))
+            ("distribution", "Key distribution to use [UNIFORM | SELFSIMILAR | ZIPFIAN | LATEST | SCRAMBLED_ZIPFIAN | CLUSTERED_ZIPFIAN | HOTSPOT]", cxxopts::value<std::string>()->default_value("UNIFORM"))
             ("skew", "Key distribution skew factor to use", cxxopts::value<float>()->default_value(std::to_string(opt.key_skew)))
+            ("hot_set", "Fraction of the keyspace in the hot set of the hotspot distribution", cxxopts::value<double>()->default_value(std::to_string(opt.hot_set)))
+            ("hot_ops", "Fraction of the operations on the hot set of the hotspot distribution", cxxopts::value<double>()->default_value(std::to_string(opt.hot_ops)))
+            ("hot_shift", "How the hot set moves during the run [none | slide | jump]", cxxopts::value<std::string>()->default_value("none"))
+            ("hot_shift_ms", "Interval between moves of the hot set in milliseconds (whole sampling windows)", cxxopts::value<double>()->default_value(std::to_string(opt.hot_shift_ms)))
+            ("hot_step", "Fraction of the keyspace the hot set slides by", cxxopts::value<double>()->default_value(std::to_string(opt.hot_step)))
             ("seed", "Seed for random generators", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.rnd_seed)))
             ("pcm", "Turn on Intel PCM", cxxopts::value<bool>()->default_value((opt.enable_pcm ? "true" : "false")))
             ("pool_path", "Path to persistent pool", cxxopts::value<std::string>()->default_value("\"" + tree_opt.pool_path + "\""))
             ("pool_size", "Size of persistent pool (in Bytes)", cxxopts::value<uint64_t>()->default_value(std::to_string(tree_opt.pool_size)))
             ("skip_load", "Skip the load phase", cxxopts::value<bool>()->default_value((opt.skip_load ? "true" : "false")))
+            ("load_mode", "How records are loaded [insert | bulk (sorted, through bulk_load, needs bigendian keys)]", cxxopts::value<std::string>()->default_value("insert"))
+            ("load_chunk", "Records per bulk_load call, 0 for all at once", cxxopts::value<uint64_t>()->default_value(std::to_string(opt.load_chunk)))
+            ("load_verify", "Look up every record after loading", cxxopts::value<bool>()->default_value((opt.load_verify ? "true" : "false")))
             ("latency_sampling", "Sample latency of requests", cxxopts::value<float>()->default_value(std::to_string(opt.latency_sampling)))
+            ("latency_timer", "Clock used to measure latency [chrono | tsc]", cxxopts::value<std::string>()->default_value("chrono"))
+            ("subtract_timer_overhead", "Subtract measured timer overhead from latencies", cxxopts::value<bool>()->default_value((opt.subtract_timer_overhead ? "true" : "false")))
             ("m,mode","Benchmark mode",cxxopts::value<std::string>()->default_value("operation"))
             ("seconds","Time (seconds) PiBench run in time-based mode",cxxopts::value<float>()->default_value(std::to_string(opt.seconds)))
+            ("rate", "Target aggregate rate (ops/s) of open-loop mode, 0 for closed-loop", cxxopts::value<double>()->default_value(std::to_string(opt.rate)))
+            ("arrival", "Inter-arrival times in open-loop mode [constant | poisson]", cxxopts::value<std::string>()->default_value("constant"))
+            ("pregenerate", "Generate all requests before the run (operation mode only)", cxxopts::value<bool>()->default_value((opt.pregenerate ? "true" : "false")))
+            ("batch_size", "Number of reads and inserts issued to the tree at once", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.batch_size)))
+            ("interleave", "Number of lookups each thread keeps in flight", cxxopts::value<uint32_t>()->default_value(std::to_string(opt.interleave)))
+            ("record_trace", "Record the requests of the run to a trace file (operation mode only)", cxxopts::value<std::string>())
+            ("replay_trace", "Replay requests from a trace file instead of generating them", cxxopts::value<std::string>())
+            ("workload", "YCSB core workload preset [ycsb-a | ... | ycsb-f], other options override it", cxxopts::value<std::string>())
+            ("workload_file", "File describing a sequence of workload phases to run after the load", cxxopts::value<std::string>())
+            ("affinity", "Placement of worker threads [none | compact | scatter | cores | list]", cxxopts::value<std::string>()->default_value("none"))
+            ("cpus", "CPUs to pin worker threads to, in order (e.g., 0-3,8); implies --affinity=list", cxxopts::value<std::string>())
+            ("load_mempolicy", "Memory policy while loading [default | local | interleave | bind]", cxxopts::value<std::string>()->default_value("default"))
+            ("run_mempolicy", "Memory policy while running [default | local | interleave | bind]", cxxopts::value<std::string>()->default_value("default"))
+            ("mempolicy_nodes", "NUMA nodes used by interleave and bind policies (e.g., 0-1), default all", cxxopts::value<std::string>())
+            ("output_format", "Additional machine-readable output [text | json | csv]", cxxopts::value<std::string>()->default_value("text"))
+            ("output_file", "File to write machine-readable output to", cxxopts::value<std::string>())
             ("help", "Print help")
         ;
 
@@ -71,11 +338,51 @@ int main(int argc, char** argv)
             opt.skip_load = result["skip_load"].as<bool>();
         }
 
+        // Parse "load_mode"
+        if (result.count("load_mode"))
+        {
+            std::string mode = result["load_mode"].as<std::string>();
+            if (!parse_load_mode(mode, opt.load_mode))
+            {
+                std::cout << "Load mode must be one of [insert | bulk], but is " << mode << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "load_chunk"
+        if (result.count("load_chunk"))
+            opt.load_chunk = result["load_chunk"].as<uint64_t>();
+
+        // Parse "load_verify"
+        if (result.count("load_verify"))
+            opt.load_verify = result["load_verify"].as<bool>();
+
         if (result.count("latency_sampling"))
         {
             opt.latency_sampling = result["latency_sampling"].as<float>();
         }
 
+        // Parse 'latency_timer'
+        if (result.count("latency_timer"))
+        {
+            std::string timer = result["latency_timer"].as<std::string>();
+            std::transform(timer.begin(), timer.end(), timer.begin(), ::tolower);
+            if (timer.compare("chrono") == 0)
+                opt.latency_timer = timer_source_t::CHRONO;
+            else if (timer.compare("tsc") == 0)
+                opt.latency_timer = timer_source_t::TSC;
+            else
+            {
+                std::cout << "Latency timer must be one of [chrono | tsc], but is " << timer << std::endl;
+                exit(1);
+            }
+        }
+
+        if (result.count("subtract_timer_overhead"))
+        {
+            opt.subtract_timer_overhead = result["subtract_timer_overhead"].as<bool>();
+        }
+
         if (result.count("input"))
         {
             opt.library_file = result["input"].as<std::string>();
@@ -87,6 +394,18 @@ int main(int argc, char** argv)
             exit(0);
         }
 
+        // Parse "workload" first, so options given explicitly override the preset
+        if (result.count("workload"))
+        {
+            std::string workload = result["workload"].as<std::string>();
+            if (!apply_workload_preset(workload, opt))
+            {
+                std::cout << "Workload must be one of [ycsb-a | ycsb-b | ycsb-c | ycsb-d | ycsb-e | ycsb-f], but is "
+                    << workload << std::endl;
+                exit(1);
+            }
+        }
+
         // Parse "num_records"
         if (result.count("records"))
             opt.num_records = result["records"].as<uint64_t>();
@@ -97,7 +416,7 @@ int main(int argc, char** argv)
 
         // Parse "sampling_ms"
         if (result.count("sampling_ms"))
-            opt.sampling_ms = result["sampling_ms"].as<uint32_t>();
+            opt.sampling_ms = result["sampling_ms"].as<double>();
 
         // Parse "key_prefix"
         if (result.count("key_prefix"))
@@ -107,6 +426,32 @@ int main(int argc, char** argv)
         if (result.count("key_size"))
             opt.key_size = result["key_size"].as<uint32_t>();
 
+        // Parse "key_order"
+        if (result.count("key_order"))
+        {
+            std::string order = result["key_order"].as<std::string>();
+            if (!parse_key_order(order, opt.key_order))
+            {
+                std::cout << "Key order must be one of [hashed | sequential | reverse | ksorted | monotonic], but is " << order << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "key_displacement"
+        if (result.count("key_displacement"))
+            opt.key_displacement = result["key_displacement"].as<uint64_t>();
+
+        // Parse "key_encoding"
+        if (result.count("key_encoding"))
+        {
+            std::string encoding = result["key_encoding"].as<std::string>();
+            if (!parse_key_encoding(encoding, opt.key_encoding))
+            {
+                std::cout << "Key encoding must be one of [native | bigendian], but is " << encoding << std::endl;
+                exit(1);
+            }
+        }
+
         // Parse "value_size"
         if (result.count("value_size"))
             opt.value_size = result["value_size"].as<uint32_t>();
@@ -127,30 +472,32 @@ int main(int argc, char** argv)
         if (result.count("scan_ratio"))
             opt.scan_ratio = result["scan_ratio"].as<float>();
 
+        if (result.count("rmw_ratio"))
+            opt.rmw_ratio = result["rmw_ratio"].as<float>();
+
         // Parse 'scan_size'.
         if (result.count("scan_size"))
             opt.scan_size = result["scan_size"].as<uint32_t>();
 
+        // Parse 'scan_length'
+        if (result.count("scan_length"))
+        {
+            std::string length = result["scan_length"].as<std::string>();
+            if (!parse_scan_length(length, opt.scan_length))
+            {
+                std::cout << "Scan length must be one of [constant | uniform], but is " << length << std::endl;
+                exit(1);
+            }
+        }
+
         // Parse 'key_distribution'
         if(result.count("distribution"))
         {
             std::string dist = result["distribution"].as<std::string>();
-            std::transform(dist.begin(), dist.end(), dist.begin(), ::tolower);
-            if(dist.compare("uniform") == 0)
-                opt.key_distribution = distribution_t::UNIFORM;
-            else if(dist.compare("selfsimilar") == 0)
-                opt.key_distribution = distribution_t::SELFSIMILAR;
-            else if(dist.compare("zipfian") == 0)
-            {
-                std::cout
-                    << "WARNING: initializing ZIPFIAN generator might take time."
-                    << std::endl;
-                opt.key_distribution = distribution_t::ZIPFIAN;
-            }
-            else
+            if(!parse_distribution(dist, opt.key_distribution))
             {
                 std::cout << "Invalid key distribution, must be one of "
-                << "[UNIFORM | SELFSIMILAR | ZIPFIAN], but is " << dist << std::endl;
+                << "[UNIFORM | SELFSIMILAR | ZIPFIAN | LATEST | SCRAMBLED_ZIPFIAN | CLUSTERED_ZIPFIAN | HOTSPOT], but is " << dist << std::endl;
                 exit(1);
             }
         }
@@ -159,6 +506,33 @@ int main(int argc, char** argv)
         if (result.count("skew"))
             opt.key_skew = result["skew"].as<float>();
 
+        // Parse "hot_set"
+        if (result.count("hot_set"))
+            opt.hot_set = result["hot_set"].as<double>();
+
+        // Parse "hot_ops"
+        if (result.count("hot_ops"))
+            opt.hot_ops = result["hot_ops"].as<double>();
+
+        // Parse "hot_shift"
+        if (result.count("hot_shift"))
+        {
+            std::string shift = result["hot_shift"].as<std::string>();
+            if (!parse_hot_shift(shift, opt.hot_shift))
+            {
+                std::cout << "Hot set shift must be one of [none | slide | jump], but is " << shift << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "hot_shift_ms"
+        if (result.count("hot_shift_ms"))
+            opt.hot_shift_ms = result["hot_shift_ms"].as<double>();
+
+        // Parse "hot_step"
+        if (result.count("hot_step"))
+            opt.hot_step = result["hot_step"].as<double>();
+
         // Parse 'rnd_seed'
         if (result.count("seed"))
         {
@@ -212,6 +586,110 @@ int main(int argc, char** argv)
         // Parse "seconds"
         if (result.count("seconds"))
             opt.seconds = result["seconds"].as<float>();
+
+        // Parse "workload_file"
+        if (result.count("workload_file"))
+            workload_file = result["workload_file"].as<std::string>();
+
+        // Parse "affinity"
+        if (result.count("affinity"))
+        {
+            std::string affinity = result["affinity"].as<std::string>();
+            if (!parse_affinity(affinity, opt.affinity))
+            {
+                std::cout << "Affinity must be one of [none | compact | scatter | cores | list], but is " << affinity << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "cpus"
+        if (result.count("cpus"))
+        {
+            std::string cpus = result["cpus"].as<std::string>();
+            if (!parse_cpu_list(cpus, opt.cpus))
+            {
+                std::cout << "Invalid CPU list: " << cpus << std::endl;
+                exit(1);
+            }
+
+            if (!result.count("affinity"))
+                opt.affinity = affinity_t::LIST;
+        }
+
+        // Parse "load_mempolicy" and "run_mempolicy"
+        for (auto name : {"load_mempolicy", "run_mempolicy"})
+        {
+            if (!result.count(name))
+                continue;
+
+            std::string policy = result[name].as<std::string>();
+            if (!parse_mempolicy(policy, name == std::string("load_mempolicy") ? opt.load_mempolicy : opt.run_mempolicy))
+            {
+                std::cout << "Memory policy must be one of [default | local | interleave | bind], but is " << policy << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "mempolicy_nodes"
+        if (result.count("mempolicy_nodes"))
+        {
+            std::string nodes = result["mempolicy_nodes"].as<std::string>();
+            if (!parse_cpu_list(nodes, opt.mempolicy_nodes))
+            {
+                std::cout << "Invalid list of NUMA nodes: " << nodes << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "output_format"
+        if (result.count("output_format"))
+        {
+            std::string format = result["output_format"].as<std::string>();
+            if (!parse_output_format(format, output_format))
+            {
+                std::cout << "Output format must be one of [text | json | csv], but is " << format << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "output_file"
+        if (result.count("output_file"))
+            output_file = result["output_file"].as<std::string>();
+
+        // Parse "rate"
+        if (result.count("rate"))
+            opt.rate = result["rate"].as<double>();
+
+        // Parse "arrival"
+        if (result.count("arrival"))
+        {
+            std::string arrival = result["arrival"].as<std::string>();
+            if (!parse_arrival(arrival, opt.arrival))
+            {
+                std::cout << "Arrival must be one of [constant | poisson], but is " << arrival << std::endl;
+                exit(1);
+            }
+        }
+
+        // Parse "pregenerate"
+        if (result.count("pregenerate"))
+            opt.pregenerate = result["pregenerate"].as<bool>();
+
+        // Parse "batch_size"
+        if (result.count("batch_size"))
+            opt.batch_size = result["batch_size"].as<uint32_t>();
+
+        // Parse "interleave"
+        if (result.count("interleave"))
+            opt.interleave = result["interleave"].as<uint32_t>();
+
+        // Parse "record_trace"
+        if (result.count("record_trace"))
+            opt.record_trace = result["record_trace"].as<std::string>();
+
+        // Parse "replay_trace"
+        if (result.count("replay_trace"))
+            opt.replay_trace = result["replay_trace"].as<std::string>();
     }
     catch (const cxxopts::OptionException& e)
     {
@@ -220,59 +698,98 @@ int main(int argc, char** argv)
     }
 
     // Sanitize options
-    if(opt.key_prefix.size() + opt.key_size > key_generator_t::KEY_MAX)
-    {
-        std::cout << "Total key size cannot be greater than " << key_generator_t::KEY_MAX
-            << ", but is " << opt.key_prefix.size() + opt.key_size << std::endl;
+    if(!sanitize(opt) || !prepare_trace(opt))
         exit(1);
-    }
 
-    if(opt.value_size > value_generator_t::VALUE_MAX)
+    std::vector<phase_t> phases;
+    if(!workload_file.empty())
     {
-        std::cout << "Total value size cannot be greater than " << value_generator_t::VALUE_MAX
-            << ", but is " << opt.value_size << std::endl;
-        exit(1);
-    }
+        try
+        {
+            phases = parse_workload_file(workload_file, opt);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cout << "Error parsing workload file: " << e.what() << std::endl;
+            exit(1);
+        }
 
-    auto sum = opt.read_ratio+opt.insert_ratio+opt.update_ratio+opt.remove_ratio+opt.scan_ratio;
-    if (sum != 1.0)
-    {
-        std::cout << "Sum of ratios should be 1.0 but is " << sum << std::endl;
-        exit(1);
+        for(auto& phase : phases)
+        {
+            if(!sanitize(phase.opt) || !prepare_trace(phase.opt))
+            {
+                std::cout << "Invalid options in workload phase '" << phase.name << "'." << std::endl;
+                exit(1);
+            }
+        }
     }
 
-    if(opt.scan_size < 1 || opt.scan_size > benchmark_t::MAX_SCAN)
+    if(opt.affinity == affinity_t::LIST)
     {
-        std::cout << "Scan size must be in the range [1," << value_generator_t::VALUE_MAX
-            << "], but is " << opt.scan_size << std::endl;
-        exit(1);
-    }
+        if(opt.cpus.empty())
+        {
+            std::cout << "Affinity 'list' requires option 'cpus'." << std::endl;
+            exit(1);
+        }
 
-    if(opt.key_distribution == distribution_t::SELFSIMILAR && (opt.key_skew < 0.0 || opt.key_skew > 0.5))
-    {
-        std::cout << "Skew factor must be in the range [0 , 0.5]." << std::endl;
-        exit(1);
+        auto topology = read_topology();
+        for(auto cpu : opt.cpus)
+        {
+            auto it = std::find_if(topology.begin(), topology.end(), [&](const cpu_t& c) { return c.id == cpu; });
+            if(it == topology.end())
+            {
+                std::cout << "CPU " << cpu << " is not online." << std::endl;
+                exit(1);
+            }
+        }
     }
 
-    if(opt.key_distribution == distribution_t::ZIPFIAN && (opt.key_skew < 0.0 || opt.key_skew > 1.0))
+    if(opt.latency_timer == timer_source_t::TSC && !latency_timer_t::tsc_supported())
     {
-        std::cout << "Skew factor must be in the range [0.0 , 1.0]." << std::endl;
+        std::cout << "TSC latency timer requires an invariant TSC, which is not available." << std::endl;
         exit(1);
     }
 
-    if((opt.latency_sampling < 0.0 || opt.latency_sampling > 1.0))
+    // Open output file before running, so a bad path does not waste a run
+    std::ofstream output;
+    if(output_format != output_format_t::TEXT)
     {
-        std::cout << "Latency sampling must be in the range [0.0 , 1.0]." << std::endl;
-        exit(1);
+        if(output_file.empty())
+        {
+            std::cout << "Option 'output_file' is required with JSON and CSV output formats." << std::endl;
+            exit(1);
+        }
+
+        output.open(output_file);
+        if(!output.good())
+        {
+            std::cout << "Could not open output file '" << output_file << "'." << std::endl;
+            exit(1);
+        }
     }
 
     // Print env and options
-    print_environment();
+    auto env = get_environment();
+    print_environment(env);
     std::cout << opt << std::endl;
 
     tree_opt.key_size = opt.key_prefix.size() + opt.key_size;
     tree_opt.value_size = opt.value_size;
     tree_opt.num_threads = opt.num_threads;
+    tree_opt.big_endian_keys = opt.key_encoding == key_encoding_t::BIGENDIAN;
+    for(auto& phase : phases)
+        tree_opt.num_threads = std::max<size_t>(tree_opt.num_threads, phase.opt.num_threads);
+
+    // Allocations made by the tree when it is created follow the load policy
+    if(opt.load_mempolicy != mempolicy_t::DEFAULT || opt.run_mempolicy != mempolicy_t::DEFAULT)
+    {
+        auto nodes = opt.mempolicy_nodes.empty() ? numa_nodes(read_topology()) : opt.mempolicy_nodes;
+        if(!apply_mempolicy(opt.load_mempolicy, nodes))
+        {
+            std::cout << "Could not set memory policy " << opt.load_mempolicy << "." << std::endl;
+            exit(1);
+        }
+    }
 
     library_loader_t lib(opt.library_file);
     tree_api* tree = lib.create_tree(tree_opt);
@@ -283,8 +800,29 @@ int main(int argc, char** argv)
     }
 
     benchmark_t bench(tree, opt);
-    bench.load();
-    bench.run();
+    auto load_result = bench.load();
+
+    std::vector<result_t> results;
+    if(phases.empty())
+    {
+        results.push_back(bench.run());
+    }
+    else
+    {
+        for(size_t i=0; i<phases.size(); ++i)
+        {
+            std::cout << "Phase " << i+1 << "/" << phases.size() << ": " << phases[i].name << "\n"
+                      << phases[i].opt << std::endl;
+            bench.configure(phases[i].opt);
+            results.push_back(bench.run());
+            results.back().name = phases[i].name;
+        }
+    }
+
+    if(output_format == output_format_t::JSON)
+        write_json(output, env, results, load_result);
+    else if(output_format == output_format_t::CSV)
+        write_csv(output, env, results, load_result);
 
     delete tree;
     return 0;
@@ -0,0 +1,743 @@
+#include "result_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace PiBench
+{
+
+namespace
+{
+
+/**
+ * @brief A named value already formatted as text.
+ *
+ */
+struct field_t
+{
+    std::string key;
+    std::string value;
+
+    /// Whether the value is a number (or boolean), written unquoted in JSON.
+    bool number;
+};
+
+std::string to_text(double v)
+{
+    if (!std::isfinite(v))
+        return "null";
+
+    std::ostringstream os;
+    os << std::setprecision(15) << v;
+    return os.str();
+}
+
+std::string to_text(uint64_t v)
+{
+    return std::to_string(v);
+}
+
+template <typename T>
+std::string to_name(const T& v)
+{
+    std::ostringstream os;
+    os << v;
+    auto name = os.str();
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return name;
+}
+
+field_t number(const std::string& key, double v) { return field_t{key, to_text(v), true}; }
+field_t number(const std::string& key, uint64_t v) { return field_t{key, to_text(v), true}; }
+field_t boolean(const std::string& key, bool v) { return field_t{key, v ? "true" : "false", true}; }
+field_t text(const std::string& key, const std::string& v) { return field_t{key, v, false}; }
+field_t integer(const std::string& key, int64_t v) { return field_t{key, std::to_string(v), true}; }
+
+std::string cpu_list(const std::vector<uint32_t>& cpus)
+{
+    std::string list;
+    for (auto cpu : cpus)
+        list += (list.empty() ? "" : ",") + std::to_string(cpu);
+    return list;
+}
+
+std::vector<field_t> option_fields(const options_t& opt)
+{
+    return {
+        text("library_file", opt.library_file),
+        number("records", opt.num_records),
+        text("mode", opt.bm_mode == mode_t::Operation ? "operation" : "time"),
+        number("operations", opt.bm_mode == mode_t::Operation ? opt.num_ops : 0),
+        number("seconds", uint64_t(opt.seconds)),
+        number("threads", uint64_t(opt.num_threads)),
+        number("sampling_ms", opt.sampling_ms),
+        text("key_prefix", opt.key_prefix),
+        number("key_size", uint64_t(opt.key_size)),
+        number("value_size", uint64_t(opt.value_size)),
+        number("read_ratio", double(opt.read_ratio)),
+        number("insert_ratio", double(opt.insert_ratio)),
+        number("update_ratio", double(opt.update_ratio)),
+        number("remove_ratio", double(opt.remove_ratio)),
+        number("scan_ratio", double(opt.scan_ratio)),
+        number("rmw_ratio", double(opt.rmw_ratio)),
+        number("scan_size", uint64_t(opt.scan_size)),
+        text("scan_length", to_name(opt.scan_length)),
+        text("key_order", to_name(opt.key_order)),
+        number("key_displacement", opt.key_displacement),
+        text("key_encoding", to_name(opt.key_encoding)),
+        text("distribution", to_name(opt.key_distribution)),
+        number("skew", double(opt.key_skew)),
+        number("hot_set", opt.hot_set),
+        number("hot_ops", opt.hot_ops),
+        text("hot_shift", to_name(opt.hot_shift)),
+        number("hot_shift_ms", opt.hot_shift_ms),
+        number("hot_step", opt.hot_step),
+        number("seed", uint64_t(opt.rnd_seed)),
+        boolean("pcm", opt.enable_pcm),
+        boolean("skip_load", opt.skip_load),
+        text("load_mode", to_name(opt.load_mode)),
+        number("load_chunk", opt.load_chunk),
+        boolean("load_verify", opt.load_verify),
+        number("latency_sampling", double(opt.latency_sampling)),
+        text("latency_timer", to_name(opt.latency_timer)),
+        boolean("subtract_timer_overhead", opt.subtract_timer_overhead),
+        number("rate", opt.rate),
+        text("arrival", to_name(opt.arrival)),
+        boolean("pregenerate", opt.pregenerate),
+        number("batch_size", uint64_t(opt.batch_size)),
+        number("interleave", uint64_t(opt.interleave)),
+        text("record_trace", opt.record_trace),
+        text("replay_trace", opt.replay_trace),
+        text("affinity", to_name(opt.affinity)),
+        text("cpus", cpu_list(opt.cpus)),
+        text("load_mempolicy", to_name(opt.load_mempolicy)),
+        text("run_mempolicy", to_name(opt.run_mempolicy)),
+        text("mempolicy_nodes", cpu_list(opt.mempolicy_nodes)),
+    };
+}
+
+std::vector<field_t> environment_fields(const environment_t& env)
+{
+    return {
+        text("time", env.time),
+        number("cpus", env.num_cpus),
+        text("cpu", env.cpu_type),
+        text("cpu_cache", env.cache_size),
+        text("kernel", env.kernel),
+    };
+}
+
+std::vector<field_t> latency_fields(const latency_summary_t& l)
+{
+    return {
+        number("count", l.count),
+        number("mean", l.mean),
+        number("min", l.min),
+        number("p50", l.p50),
+        number("p90", l.p90),
+        number("p99", l.p99),
+        number("p99.9", l.p999),
+        number("p99.99", l.p9999),
+        number("p99.999", l.p99999),
+        number("max", l.max),
+    };
+}
+
+std::vector<field_t> socket_fields(const socket_result_t& s, double seconds)
+{
+    return {
+        number("socket", uint64_t(s.socket)),
+        number("threads", uint64_t(s.threads)),
+        number("operations", s.total.operation_count),
+        number("completed_per_second", s.total.operation_count / seconds),
+        number("succeeded_per_second", s.total.succeeded_count() / seconds),
+    };
+}
+
+std::vector<field_t> hot_shift_fields(const hot_shift_result_t& h, double sampling_ms)
+{
+    std::vector<field_t> fields = {
+        number("window", h.window),
+        number("time_ms", h.window * sampling_ms),
+        number("before_per_second", h.before),
+    };
+    for (size_t a = 0; a < h.after.size(); ++a)
+        fields.push_back(number("after_" + std::to_string(a) + "_per_second", h.after[a]));
+    fields.push_back(number("recovery_ms", h.recovery_ms >= 0.0 ? h.recovery_ms : NAN));
+    return fields;
+}
+
+std::vector<field_t> pcm_fields(const result_t& r)
+{
+    return {
+        number("l3_misses", r.l3_misses),
+        number("dram_read_bytes", r.dram_reads),
+        number("dram_write_bytes", r.dram_writes),
+        number("nvm_read_bytes", r.nvm_reads),
+        number("nvm_write_bytes", r.nvm_writes),
+    };
+}
+
+std::vector<field_t> timer_fields(const result_t& r)
+{
+    return {
+        text("source", to_name(r.timer)),
+        number("ns_per_tick", r.timer_ns_per_tick),
+        number("min_overhead_ns", r.timer_min_overhead_ns),
+        number("overhead_ns", r.timer_overhead_ns),
+        boolean("overhead_subtracted", r.opt.subtract_timer_overhead),
+    };
+}
+
+std::vector<field_t> window_fields(const stats_t& s, const window_percentiles_t* l, size_t op)
+{
+    std::vector<field_t> fields = {
+        number("completed", s.completed[op]),
+        number("succeeded", s.succeeded[op]),
+    };
+    if (l != nullptr && l->count > 0)
+    {
+        fields.push_back(number("latency_count", l->count));
+        fields.push_back(number("p50", l->p50));
+        fields.push_back(number("p99", l->p99));
+        fields.push_back(number("p99.9", l->p999));
+        fields.push_back(number("max", l->max));
+    }
+    return fields;
+}
+
+std::vector<field_t> load_fields(const load_result_t& l)
+{
+    std::vector<field_t> fields = {
+        text("mode", to_name(l.mode)),
+        number("records", l.records),
+        number("inserted", l.inserted),
+        number("load_time_ms", l.elapsed_ms),
+        number("records_per_second", l.records / (l.elapsed_ms / 1000)),
+    };
+    if (l.mode == load_mode_t::BULK)
+        fields.push_back(number("sort_time_ms", l.sort_ms));
+    if (l.resident_memory > 0)
+    {
+        fields.push_back(integer("memory_footprint_bytes", l.memory_footprint));
+        fields.push_back(number("resident_memory_bytes", l.resident_memory));
+    }
+    fields.push_back(boolean("verified", l.verified));
+    if (l.verified)
+    {
+        fields.push_back(number("verify_time_ms", l.verify_ms));
+        fields.push_back(number("missing", l.missing));
+    }
+    return fields;
+}
+
+std::vector<field_t> load_window_fields(const load_result_t& l, size_t w)
+{
+    std::vector<field_t> fields = {
+        number("time_ms", (w + 1) * l.sampling_ms),
+        number("records", l.samples[w]),
+    };
+    if (w < l.sample_latencies.size() && l.sample_latencies[w].count > 0)
+    {
+        const auto& p = l.sample_latencies[w];
+        fields.push_back(number("latency_count", p.count));
+        fields.push_back(number("p50", p.p50));
+        fields.push_back(number("p99", p.p99));
+        fields.push_back(number("p99.9", p.p999));
+        fields.push_back(number("max", p.max));
+    }
+    return fields;
+}
+
+/**
+ * @brief Minimal streaming JSON writer.
+ *
+ */
+class json_writer_t
+{
+public:
+    explicit json_writer_t(std::ostream& os) : os_(os) {}
+
+    void begin_object(const std::string& key = "") { open(key, '{'); }
+    void end_object() { close('}'); }
+    void begin_array(const std::string& key = "") { open(key, '['); }
+    void end_array() { close(']'); }
+
+    void field(const field_t& f)
+    {
+        separator();
+        string(f.key);
+        os_ << ": ";
+        if (f.number)
+            os_ << f.value;
+        else
+            string(f.value);
+    }
+
+    void fields(const std::vector<field_t>& fs)
+    {
+        for (auto& f : fs)
+            field(f);
+    }
+
+    void object(const std::string& key, const std::vector<field_t>& fs)
+    {
+        begin_object(key);
+        fields(fs);
+        end_object();
+    }
+
+private:
+    void open(const std::string& key, char c)
+    {
+        separator();
+        if (!key.empty())
+        {
+            string(key);
+            os_ << ": ";
+        }
+        os_ << c;
+        first_.push_back(true);
+    }
+
+    void close(char c)
+    {
+        first_.pop_back();
+        newline();
+        os_ << c;
+    }
+
+    void separator()
+    {
+        if (first_.empty())
+            return;
+        if (!first_.back())
+            os_ << ',';
+        first_.back() = false;
+        newline();
+    }
+
+    void newline()
+    {
+        os_ << '\n' << std::string(2 * first_.size(), ' ');
+    }
+
+    void string(const std::string& s)
+    {
+        os_ << '"';
+        for (unsigned char c : s)
+        {
+            switch (c)
+            {
+            case '"': os_ << "\\\""; break;
+            case '\\': os_ << "\\\\"; break;
+            case '\n': os_ << "\\n"; break;
+            case '\t': os_ << "\\t"; break;
+            case '\r': os_ << "\\r"; break;
+            default:
+                if (c < 0x20)
+                    os_ << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                        << std::dec << std::setfill(' ');
+                else
+                    os_ << c;
+            }
+        }
+        os_ << '"';
+    }
+
+    std::ostream& os_;
+
+    /// Whether the next element is the first one, per nesting level.
+    std::vector<bool> first_;
+};
+
+std::string csv_escape(const std::string& s)
+{
+    if (s.find_first_of(",\"\n\r") == std::string::npos)
+        return s;
+
+    std::string escaped = "\"";
+    for (char c : s)
+    {
+        if (c == '"')
+            escaped += '"';
+        escaped += c;
+    }
+    return escaped + '"';
+}
+
+/**
+ * @brief Writes rows of the long-format CSV.
+ *
+ */
+class csv_writer_t
+{
+public:
+    explicit csv_writer_t(std::ostream& os) : os_(os)
+    {
+        os_ << "phase,section,operation,outcome,window,metric,value\n";
+    }
+
+    /// Columns shared by the following rows.
+    std::string phase;
+    std::string section;
+    std::string operation;
+    std::string outcome;
+    std::string window;
+
+    void rows(const std::vector<field_t>& fs)
+    {
+        for (auto& f : fs)
+        {
+            os_ << csv_escape(phase) << ','
+                << csv_escape(section) << ','
+                << csv_escape(operation) << ','
+                << csv_escape(outcome) << ','
+                << window << ','
+                << csv_escape(f.key) << ','
+                << csv_escape(f.value) << '\n';
+        }
+    }
+
+private:
+    std::ostream& os_;
+};
+
+} // namespace
+
+bool parse_output_format(std::string name, output_format_t& format)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.compare("text") == 0)
+        format = output_format_t::TEXT;
+    else if (name.compare("json") == 0)
+        format = output_format_t::JSON;
+    else if (name.compare("csv") == 0)
+        format = output_format_t::CSV;
+    else
+        return false;
+    return true;
+}
+
+void write_json(std::ostream& os, const environment_t& env, const std::vector<result_t>& results,
+                const load_result_t& load)
+{
+    json_writer_t json(os);
+    json.begin_object();
+    json.object("environment", environment_fields(env));
+    if (load.loaded)
+    {
+        json.begin_object("load");
+        json.fields(load_fields(load));
+        if (load.has_latency)
+            json.object("latency", latency_fields(load.latency));
+        json.begin_array("samples");
+        for (size_t w = 0; w < load.samples.size(); ++w)
+        {
+            json.begin_object();
+            json.fields(load_window_fields(load, w));
+            json.end_object();
+        }
+        json.end_array();
+        json.end_object();
+    }
+    json.begin_array("runs");
+    for (auto& r : results)
+    {
+        const double seconds = r.elapsed_ms / 1000;
+
+        json.begin_object();
+        json.field(text("name", r.name));
+        json.object("options", option_fields(r.opt));
+        json.field(number("run_time_ms", r.elapsed_ms));
+        json.field(number("operations", r.total.operation_count));
+        json.object("throughput", {
+            number("completed", r.total.operation_count / seconds),
+            number("succeeded", r.total.succeeded_count() / seconds),
+        });
+
+        json.begin_object("breakdown");
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            json.object(to_name(static_cast<operation_t>(op)), {
+                number("completed", r.total.completed[op]),
+                number("succeeded", r.total.succeeded[op]),
+                number("completed_per_second", r.total.completed[op] / seconds),
+                number("succeeded_per_second", r.total.succeeded[op] / seconds),
+            });
+        }
+        json.end_object();
+
+        if (r.opt.pregenerate)
+        {
+            json.object("pregeneration", {
+                number("generation_ms", r.generation_ms),
+                number("generation_ns_per_op", r.generation_ns_per_op),
+            });
+        }
+
+        if (r.opt.rate > 0.0)
+        {
+            json.object("open_loop", {
+                number("offered_load", r.opt.rate),
+                number("schedule_lag_ms", r.schedule_lag_ms),
+            });
+        }
+
+        if (r.has_latency)
+        {
+            json.object("timer", timer_fields(r));
+            json.begin_object("latency");
+            json.object("all", latency_fields(r.latency));
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            {
+                json.begin_object(to_name(static_cast<operation_t>(op)));
+                json.object("all", latency_fields(r.op_latency[op]));
+                json.object("succeeded", latency_fields(r.op_succeeded_latency[op]));
+                json.object("failed", latency_fields(r.op_failed_latency[op]));
+                json.end_object();
+            }
+            if (r.opt.rate > 0.0)
+                json.object("service", latency_fields(r.service_latency));
+            if (r.opt.batch_size > 1)
+                json.object("batch", latency_fields(r.batch_latency));
+            json.end_object();
+        }
+
+        json.begin_array("samples");
+        for (size_t w = 0; w < r.samples.size(); ++w)
+        {
+            const auto& s = r.samples[w];
+            json.begin_object();
+            json.field(number("time_ms", (w + 1) * r.opt.sampling_ms));
+            json.field(number("operations", s.operation_count));
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            {
+                const window_percentiles_t* l = w < r.sample_latencies.size() ? &r.sample_latencies[w][op] : nullptr;
+                json.object(to_name(static_cast<operation_t>(op)), window_fields(s, l, op));
+            }
+            json.end_object();
+        }
+        json.end_array();
+
+        if (!r.hot_shifts.empty())
+        {
+            json.begin_array("hot_shifts");
+            for (const auto& h : r.hot_shifts)
+            {
+                json.begin_object();
+                json.fields(hot_shift_fields(h, r.opt.sampling_ms));
+                json.end_object();
+            }
+            json.end_array();
+        }
+
+        json.begin_object("placement");
+        json.field(integer("monitor_cpu", r.monitor_cpu));
+        json.begin_array("threads");
+        for (size_t tid = 0; tid < r.worker_cpus.size(); ++tid)
+        {
+            json.begin_object();
+            json.fields({
+                integer("cpu", r.worker_cpus[tid]),
+                integer("node", r.worker_nodes[tid]),
+            });
+            json.end_object();
+        }
+        json.end_array();
+        json.end_object();
+
+        if (!r.sockets.empty())
+        {
+            json.begin_array("sockets");
+            for (auto& s : r.sockets)
+            {
+                json.begin_object();
+                json.fields(socket_fields(s, seconds));
+                if (r.has_latency)
+                    json.object("latency", latency_fields(s.latency));
+                json.end_object();
+            }
+            json.end_array();
+        }
+
+        if (r.has_pcm)
+            json.object("pcm", pcm_fields(r));
+
+        json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+    os << std::endl;
+}
+
+void write_csv(std::ostream& os, const environment_t& env, const std::vector<result_t>& results,
+               const load_result_t& load)
+{
+    csv_writer_t csv(os);
+
+    csv.section = "environment";
+    csv.rows(environment_fields(env));
+
+    if (load.loaded)
+    {
+        csv.phase = "load";
+        csv.section = "result";
+        csv.rows(load_fields(load));
+        if (load.has_latency)
+        {
+            csv.section = "latency";
+            csv.operation = "insert";
+            csv.outcome = "all";
+            csv.rows(latency_fields(load.latency));
+            csv.operation = csv.outcome = "";
+        }
+        csv.section = "sample";
+        for (size_t w = 0; w < load.samples.size(); ++w)
+        {
+            csv.window = std::to_string(w);
+            csv.rows(load_window_fields(load, w));
+        }
+        csv.window = "";
+    }
+
+    for (auto& r : results)
+    {
+        const double seconds = r.elapsed_ms / 1000;
+
+        csv.phase = r.name;
+        csv.operation = csv.outcome = csv.window = "";
+
+        csv.section = "option";
+        csv.rows(option_fields(r.opt));
+
+        csv.section = "result";
+        std::vector<field_t> summary = {
+            number("run_time_ms", r.elapsed_ms),
+            number("operations", r.total.operation_count),
+            number("completed_per_second", r.total.operation_count / seconds),
+            number("succeeded_per_second", r.total.succeeded_count() / seconds),
+        };
+        if (r.opt.rate > 0.0)
+        {
+            summary.push_back(number("offered_load", r.opt.rate));
+            summary.push_back(number("schedule_lag_ms", r.schedule_lag_ms));
+        }
+        if (r.opt.pregenerate)
+        {
+            summary.push_back(number("generation_ms", r.generation_ms));
+            summary.push_back(number("generation_ns_per_op", r.generation_ns_per_op));
+        }
+        csv.rows(summary);
+
+        csv.section = "throughput";
+        for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+        {
+            csv.operation = to_name(static_cast<operation_t>(op));
+            csv.rows({
+                number("completed", r.total.completed[op]),
+                number("succeeded", r.total.succeeded[op]),
+                number("completed_per_second", r.total.completed[op] / seconds),
+                number("succeeded_per_second", r.total.succeeded[op] / seconds),
+            });
+        }
+        csv.operation = "";
+
+        if (r.has_latency)
+        {
+            csv.section = "timer";
+            csv.rows(timer_fields(r));
+
+            csv.section = "latency";
+            csv.operation = "all";
+            csv.outcome = "all";
+            csv.rows(latency_fields(r.latency));
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            {
+                csv.operation = to_name(static_cast<operation_t>(op));
+                csv.outcome = "all";
+                csv.rows(latency_fields(r.op_latency[op]));
+                csv.outcome = "succeeded";
+                csv.rows(latency_fields(r.op_succeeded_latency[op]));
+                csv.outcome = "failed";
+                csv.rows(latency_fields(r.op_failed_latency[op]));
+            }
+            if (r.opt.rate > 0.0)
+            {
+                csv.operation = "service";
+                csv.outcome = "all";
+                csv.rows(latency_fields(r.service_latency));
+            }
+            if (r.opt.batch_size > 1)
+            {
+                csv.operation = "batch";
+                csv.outcome = "all";
+                csv.rows(latency_fields(r.batch_latency));
+            }
+            csv.operation = csv.outcome = "";
+        }
+
+        csv.section = "sample";
+        for (size_t w = 0; w < r.samples.size(); ++w)
+        {
+            const auto& s = r.samples[w];
+            csv.window = std::to_string(w);
+            csv.operation = "";
+            csv.rows({
+                number("time_ms", (w + 1) * r.opt.sampling_ms),
+                number("operations", s.operation_count),
+            });
+            for (size_t op = 0; op < NUM_OPERATIONS; ++op)
+            {
+                if (s.completed[op] == 0)
+                    continue;
+                const window_percentiles_t* l = w < r.sample_latencies.size() ? &r.sample_latencies[w][op] : nullptr;
+                csv.operation = to_name(static_cast<operation_t>(op));
+                csv.rows(window_fields(s, l, op));
+            }
+        }
+        csv.window = csv.operation = "";
+
+        csv.section = "hot_shift";
+        for (const auto& h : r.hot_shifts)
+        {
+            csv.window = std::to_string(h.window);
+            csv.rows(hot_shift_fields(h, r.opt.sampling_ms));
+        }
+        csv.window = "";
+
+        csv.section = "placement";
+        std::vector<field_t> placement = {integer("monitor_cpu", r.monitor_cpu)};
+        for (size_t tid = 0; tid < r.worker_cpus.size(); ++tid)
+        {
+            placement.push_back(integer("thread." + std::to_string(tid) + ".cpu", r.worker_cpus[tid]));
+            placement.push_back(integer("thread." + std::to_string(tid) + ".node", r.worker_nodes[tid]));
+        }
+        csv.rows(placement);
+
+        for (auto& s : r.sockets)
+        {
+            csv.section = "socket";
+            csv.operation = std::to_string(s.socket);
+            csv.rows(socket_fields(s, seconds));
+            if (r.has_latency)
+            {
+                csv.outcome = "all";
+                csv.rows(latency_fields(s.latency));
+                csv.outcome = "";
+            }
+            csv.operation = "";
+        }
+
+        if (r.has_pcm)
+        {
+            csv.section = "pcm";
+            csv.rows(pcm_fields(r));
+        }
+    }
+    os << std::flush;
+}
+
+} // namespace PiBench
@@ -0,0 +1,399 @@
+#include "trace.hpp"
+#include "key_generator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PiBench
+{
+
+namespace
+{
+
+static constexpr char MAGIC[8] = {'P', 'I', 'B', 'T', 'R', 'A', 'C', 'E'};
+static constexpr uint32_t VERSION = 1;
+
+/// Records buffered by append() before being written.
+static constexpr size_t APPEND_BUFFER = 1 << 20;
+
+std::runtime_error io_error(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " '" + path + "': " + strerror(errno));
+}
+
+void pwrite_all(int fd, const char* buf, size_t size, off_t offset, const std::string& path)
+{
+    while (size > 0)
+    {
+        auto n = ::pwrite(fd, buf, size, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw io_error("cannot write trace", path);
+        }
+        buf += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+bool parse_operation(const std::string& name, operation_t& op)
+{
+    if (name == "READ")
+        op = operation_t::READ;
+    else if (name == "INSERT")
+        op = operation_t::INSERT;
+    else if (name == "UPDATE")
+        op = operation_t::UPDATE;
+    else if (name == "DELETE")
+        op = operation_t::REMOVE;
+    else if (name == "SCAN")
+        op = operation_t::SCAN;
+    else
+        return false;
+    return true;
+}
+
+// Total length of the values in " field0=abc field1=de ", where values may
+// contain spaces but a new field starts at " name=".
+uint32_t fields_size(const std::string& fields)
+{
+    uint64_t size = 0;
+    size_t value_begin = std::string::npos;
+    size_t pos = 0;
+    while (pos < fields.size())
+    {
+        // Does a field name start here?
+        size_t name_end = pos;
+        if (pos == 0 || fields[pos - 1] == ' ')
+        {
+            while (name_end < fields.size() && (isalnum(fields[name_end]) || fields[name_end] == '_'))
+                ++name_end;
+        }
+        if (name_end > pos && name_end < fields.size() && fields[name_end] == '=')
+        {
+            if (value_begin != std::string::npos)
+                size += pos - 1 - value_begin; // Excludes separating space
+            value_begin = name_end + 1;
+            pos = value_begin;
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+    if (value_begin != std::string::npos)
+    {
+        auto end = fields.find_last_not_of(' ');
+        if (end != std::string::npos && end >= value_begin)
+            size += end + 1 - value_begin;
+    }
+    return std::min<uint64_t>(size, std::numeric_limits<uint32_t>::max());
+}
+
+} // namespace
+
+trace_writer_t::trace_writer_t(const std::string& path, uint32_t key_size)
+    : path_(path),
+      fd_(-1),
+      key_size_(key_size),
+      num_records_(0),
+      buf_index_(0)
+{
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+        throw io_error("cannot create trace", path);
+}
+
+trace_writer_t::~trace_writer_t()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+void trace_writer_t::encode(char* record, operation_t op, const char* key, uint32_t value_size, uint32_t scan_size) const noexcept
+{
+    uint16_t v = std::min<uint32_t>(value_size, std::numeric_limits<uint16_t>::max());
+    uint16_t s = std::min<uint32_t>(scan_size, std::numeric_limits<uint16_t>::max());
+    record[0] = static_cast<char>(op);
+    memcpy(record + 1, &v, sizeof(v));
+    memcpy(record + 3, &s, sizeof(s));
+    memcpy(record + RECORD_HEADER, key, key_size_);
+}
+
+void trace_writer_t::append(operation_t op, const char* key, uint32_t value_size, uint32_t scan_size)
+{
+    if (buf_.empty())
+        buf_index_ = num_records_.load(std::memory_order_relaxed);
+
+    auto offset = buf_.size();
+    buf_.resize(offset + record_size());
+    encode(&buf_[offset], op, key, value_size, scan_size);
+
+    if (buf_.size() >= APPEND_BUFFER)
+        flush();
+}
+
+void trace_writer_t::flush()
+{
+    if (buf_.empty())
+        return;
+    auto count = buf_.size() / record_size();
+    write(buf_index_, buf_.data(), count);
+    buf_.clear();
+}
+
+void trace_writer_t::write(uint64_t index, const char* records, uint64_t count)
+{
+    pwrite_all(fd_, records, count * record_size(), sizeof(trace_header_t) + index * record_size(), path_);
+
+    // Keep track of the highest record written
+    auto end = index + count;
+    auto current = num_records_.load(std::memory_order_relaxed);
+    while (current < end && !num_records_.compare_exchange_weak(current, end, std::memory_order_relaxed))
+        ;
+}
+
+uint64_t trace_writer_t::close()
+{
+    flush();
+
+    trace_header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key_size = key_size_;
+    header.num_records = num_records_.load(std::memory_order_relaxed);
+    pwrite_all(fd_, reinterpret_cast<const char*>(&header), sizeof(header), 0, path_);
+
+    // Records never written (if any) read as zeroes
+    if (ftruncate(fd_, sizeof(header) + header.num_records * record_size()) != 0)
+        throw io_error("cannot write trace", path_);
+
+    auto fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0)
+        throw io_error("cannot write trace", path_);
+    return header.num_records;
+}
+
+trace_reader_t::trace_reader_t(const std::string& path)
+    : data_(nullptr),
+      length_(0),
+      key_size_(0),
+      num_records_(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw io_error("cannot open trace", path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw io_error("cannot open trace", path);
+    }
+    length_ = st.st_size;
+    if (length_ < sizeof(trace_header_t))
+    {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is not a trace");
+    }
+
+    void* data = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        throw io_error("cannot map trace", path);
+    data_ = static_cast<char*>(data);
+
+    trace_header_t header;
+    memcpy(&header, data_, sizeof(header));
+    std::string error;
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        error = "'" + path + "' is not a trace";
+    else if (header.version != VERSION)
+        error = "unsupported version " + std::to_string(header.version) + " of trace '" + path + "'";
+    else if (header.key_size == 0 || header.key_size > key_generator_t::KEY_MAX)
+        error = "invalid key size " + std::to_string(header.key_size) + " in trace '" + path + "'";
+    else if ((length_ - sizeof(header)) / (trace_writer_t::RECORD_HEADER + header.key_size) < header.num_records)
+        error = "trace '" + path + "' is truncated";
+    if (!error.empty())
+    {
+        munmap(data_, length_);
+        throw std::runtime_error(error);
+    }
+    key_size_ = header.key_size;
+    num_records_ = header.num_records;
+
+    // Records are mostly read in order, let the kernel read ahead
+    madvise(data_, length_, MADV_SEQUENTIAL);
+}
+
+trace_reader_t::~trace_reader_t()
+{
+    munmap(data_, length_);
+}
+
+trace_request_t trace_reader_t::get(uint64_t i) const noexcept
+{
+    const char* record = data_ + sizeof(trace_header_t) + i * record_size();
+    uint16_t v, s;
+    memcpy(&v, record + 1, sizeof(v));
+    memcpy(&s, record + 3, sizeof(s));
+
+    trace_request_t request;
+    request.op = static_cast<operation_t>(record[0]);
+    request.value_size = v;
+    request.scan_size = s;
+    request.key = record + trace_writer_t::RECORD_HEADER;
+    return request;
+}
+
+void trace_reader_t::will_need(uint64_t first, uint64_t last) const noexcept
+{
+    advise(first, last, MADV_WILLNEED);
+}
+
+void trace_reader_t::dont_need(uint64_t first, uint64_t last) const noexcept
+{
+    advise(first, last, MADV_DONTNEED);
+}
+
+void trace_reader_t::advise(uint64_t first, uint64_t last, int advice) const noexcept
+{
+    last = std::min(last, num_records_);
+    if (first >= last)
+        return;
+
+    // Pages partially covered by the range may hold records of other
+    // threads, only release pages entirely inside it.
+    static const uintptr_t page = sysconf(_SC_PAGESIZE);
+    auto begin = reinterpret_cast<uintptr_t>(data_ + sizeof(trace_header_t) + first * record_size());
+    auto end = reinterpret_cast<uintptr_t>(data_ + sizeof(trace_header_t) + last * record_size());
+    if (advice == MADV_DONTNEED)
+    {
+        begin = (begin + page - 1) & ~(page - 1);
+        end &= ~(page - 1);
+    }
+    else
+    {
+        begin &= ~(page - 1);
+    }
+    if (begin < end)
+        madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+}
+
+trace_cursor_t::trace_cursor_t(const trace_reader_t& trace, uint64_t first, uint64_t last) noexcept
+    : trace_(trace),
+      pos_(first),
+      last_(last),
+      window_(std::max<uint64_t>(1, READAHEAD / trace.record_size())),
+      next_advice_(first),
+      released_(first)
+{
+}
+
+void trace_cursor_t::advance_window() noexcept
+{
+    // Entering a window: request the next one and release the one before.
+    if (pos_ == released_)
+        trace_.will_need(pos_, std::min(last_, pos_ + window_));
+    trace_.will_need(pos_ + window_, std::min(last_, pos_ + 2 * window_));
+    if (pos_ >= released_ + window_)
+    {
+        trace_.dont_need(released_, pos_ - window_);
+        released_ = pos_ - window_;
+    }
+    next_advice_ = pos_ + window_;
+}
+
+void trace_partition(uint64_t num_records, uint32_t num_threads, uint32_t tid, uint64_t& first, uint64_t& last)
+{
+    auto share = num_records / num_threads;
+    auto extra = num_records % num_threads;
+    first = tid * share + std::min<uint64_t>(tid, extra);
+    last = first + share + (tid < extra);
+}
+
+bool parse_ycsb_request(const std::string& line, uint32_t key_size, trace_request_t& request, char* key,
+                        key_encoding_t encoding)
+{
+    std::istringstream in(line);
+    std::string name, table, id;
+    if (!(in >> name >> table >> id) || !parse_operation(name, request.op))
+        return false;
+
+    request.value_size = 0;
+    request.scan_size = 0;
+    if (request.op == operation_t::SCAN)
+    {
+        uint64_t scan_size;
+        if (!(in >> scan_size))
+            return false;
+        request.scan_size = std::min<uint64_t>(scan_size, std::numeric_limits<uint32_t>::max());
+    }
+    else if (request.op == operation_t::INSERT || request.op == operation_t::UPDATE)
+    {
+        auto open = line.find('[');
+        auto close = line.rfind(']');
+        if (open == std::string::npos || close == std::string::npos || close < open)
+            return false;
+        request.value_size = fields_size(line.substr(open + 1, close - open - 1));
+    }
+
+    // Numeric ids after a prefix (e.g., "user1234") are stored as integers
+    auto digits = id.find_first_of("0123456789");
+    bool numeric = digits != std::string::npos
+                   && id.find_first_not_of("0123456789", digits) == std::string::npos
+                   && id.size() - digits <= 20;
+    if (numeric)
+    {
+        errno = 0;
+        uint64_t value = strtoull(id.c_str() + digits, nullptr, 10);
+        numeric = errno != ERANGE;
+        if (numeric)
+            key_generator_t::store_id(value, key, key_size, encoding);
+    }
+    if (!numeric)
+    {
+        if (id.size() > key_size)
+            return false;
+        memset(key, 0, key_size);
+        memcpy(key, id.data(), id.size());
+    }
+    request.key = key;
+    return true;
+}
+
+uint64_t import_ycsb(std::istream& in, trace_writer_t& out, uint64_t& skipped, key_encoding_t encoding)
+{
+    std::vector<char> key(out.key_size());
+    uint64_t imported = 0;
+    skipped = 0;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        trace_request_t request;
+        if (!parse_ycsb_request(line, out.key_size(), request, key.data(), encoding))
+        {
+            ++skipped;
+            continue;
+        }
+        out.append(request.op, request.key, request.value_size, request.scan_size);
+        ++imported;
+    }
+    return imported;
+}
+
+} // namespace PiBench
@@ -0,0 +1,104 @@
+#include "trace.hpp"
+#include "cxxopts.hpp"
+
+#include <fstream>
+#include <iostream>
+
+using namespace PiBench;
+
+int main(int argc, char** argv)
+{
+    std::string input_file;
+    std::string output_file;
+    uint32_t key_size = 8;
+    key_encoding_t key_encoding = key_encoding_t::NATIVE;
+    try
+    {
+        cxxopts::Options options("trace_import", "Convert YCSB text traces to PiBench binary traces.");
+        options
+            .positional_help("INPUT OUTPUT")
+            .show_positional_help();
+
+        options.add_options()
+            ("input", "YCSB trace (output of the basic DB), '-' for stdin", cxxopts::value<std::string>())
+            ("output", "Binary trace to be created", cxxopts::value<std::string>())
+            ("k,key_size", "Size of keys in bytes (including any prefix used when replaying)", cxxopts::value<uint32_t>()->default_value(std::to_string(key_size)))
+            ("key_encoding", "Byte order of numeric ids in keys [native | bigendian], must match the one used when replaying", cxxopts::value<std::string>()->default_value("native"))
+            ("help", "Print help")
+        ;
+
+        options.parse_positional({"input", "output"});
+        auto result = options.parse(argc, argv);
+        if (result.count("help"))
+        {
+            std::cout << options.help() << std::endl;
+            exit(0);
+        }
+
+        if (!result.count("input") || !result.count("output"))
+        {
+            std::cout << "Missing 'input' or 'output' argument." << std::endl;
+            std::cout << options.help() << std::endl;
+            exit(1);
+        }
+        input_file = result["input"].as<std::string>();
+        output_file = result["output"].as<std::string>();
+
+        // Parse "key_size"
+        if (result.count("key_size"))
+            key_size = result["key_size"].as<uint32_t>();
+
+        // Parse "key_encoding"
+        if (result.count("key_encoding"))
+        {
+            std::string encoding = result["key_encoding"].as<std::string>();
+            if (!parse_key_encoding(encoding, key_encoding))
+            {
+                std::cout << "Key encoding must be one of [native | bigendian], but is " << encoding << std::endl;
+                exit(1);
+            }
+        }
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        std::cout << "Error parsing options: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    if (key_size < 1 || key_size > key_generator_t::KEY_MAX)
+    {
+        std::cout << "Key size must be in the range [1," << key_generator_t::KEY_MAX << "], but is " << key_size << std::endl;
+        exit(1);
+    }
+
+    std::ifstream file;
+    if (input_file != "-")
+    {
+        file.open(input_file);
+        if (!file.good())
+        {
+            std::cout << "Could not open input file '" << input_file << "'." << std::endl;
+            exit(1);
+        }
+    }
+    std::istream& in = input_file == "-" ? std::cin : file;
+
+    try
+    {
+        trace_writer_t trace(output_file, key_size);
+        uint64_t skipped = 0;
+        auto imported = import_ycsb(in, trace, skipped, key_encoding);
+        trace.close();
+
+        std::cout << "Imported " << imported << " requests";
+        if (skipped > 0)
+            std::cout << " (" << skipped << " lines skipped)";
+        std::cout << "." << std::endl;
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -3,5 +3,5 @@
 namespace PiBench
 {
 thread_local uint32_t value_generator_t::seed_;
-thread_local std::default_random_engine value_generator_t::gen_;
+thread_local xoshiro256pp_engine value_generator_t::gen_;
 }
\ No newline at end of file
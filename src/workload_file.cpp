@@ -0,0 +1,230 @@
+#include "workload_file.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace PiBench
+{
+
+namespace
+{
+
+std::string trim(const std::string& s)
+{
+    auto begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return "";
+    auto end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+double to_double(const std::string& value)
+{
+    size_t pos = 0;
+    double d = 0.0;
+    try
+    {
+        d = std::stod(value, &pos);
+    }
+    catch (const std::logic_error&)
+    {
+        pos = 0;
+    }
+
+    if (pos == 0 || pos != value.size() || !std::isfinite(d))
+        throw std::invalid_argument("invalid number '" + value + "'");
+    return d;
+}
+
+uint64_t to_uint(const std::string& value)
+{
+    size_t pos = 0;
+    uint64_t u = 0;
+    try
+    {
+        if (!value.empty() && value[0] != '-')
+            u = std::stoull(value, &pos);
+    }
+    catch (const std::logic_error&)
+    {
+        pos = 0;
+    }
+
+    if (pos == 0 || pos != value.size())
+        throw std::invalid_argument("invalid unsigned integer '" + value + "'");
+    return u;
+}
+
+void set_option(phase_t& phase, bool& ratios_set, const std::string& key, const std::string& value)
+{
+    auto& opt = phase.opt;
+
+    // A phase specifying its own mix does not inherit any of the base ratios.
+    auto ratio = [&](float& r)
+    {
+        if (!ratios_set)
+        {
+            opt.read_ratio = opt.insert_ratio = opt.update_ratio = opt.remove_ratio = opt.scan_ratio = opt.rmw_ratio = 0.0;
+            ratios_set = true;
+        }
+        r = to_double(value);
+    };
+
+    if (key == "read_ratio")
+        ratio(opt.read_ratio);
+    else if (key == "insert_ratio")
+        ratio(opt.insert_ratio);
+    else if (key == "update_ratio")
+        ratio(opt.update_ratio);
+    else if (key == "remove_ratio")
+        ratio(opt.remove_ratio);
+    else if (key == "scan_ratio")
+        ratio(opt.scan_ratio);
+    else if (key == "rmw_ratio")
+        ratio(opt.rmw_ratio);
+    else if (key == "workload")
+    {
+        // The tree was already created for the base value size
+        auto value_size = opt.value_size;
+        if (!apply_workload_preset(value, opt))
+            throw std::invalid_argument("invalid workload '" + value + "'");
+        opt.value_size = value_size;
+        ratios_set = true;
+    }
+    else if (key == "scan_size")
+        opt.scan_size = to_uint(value);
+    else if (key == "scan_length")
+    {
+        if (!parse_scan_length(value, opt.scan_length))
+            throw std::invalid_argument("invalid scan length '" + value + "'");
+    }
+    else if (key == "distribution")
+    {
+        if (!parse_distribution(value, opt.key_distribution))
+            throw std::invalid_argument("invalid distribution '" + value + "'");
+    }
+    else if (key == "skew")
+        opt.key_skew = to_double(value);
+    else if (key == "hot_set")
+        opt.hot_set = to_double(value);
+    else if (key == "hot_ops")
+        opt.hot_ops = to_double(value);
+    else if (key == "hot_shift")
+    {
+        if (!parse_hot_shift(value, opt.hot_shift))
+            throw std::invalid_argument("invalid hot set shift '" + value + "'");
+    }
+    else if (key == "hot_shift_ms")
+        opt.hot_shift_ms = to_double(value);
+    else if (key == "hot_step")
+        opt.hot_step = to_double(value);
+    else if (key == "threads")
+        opt.num_threads = to_uint(value);
+    else if (key == "operations")
+    {
+        opt.bm_mode = mode_t::Operation;
+        opt.num_ops = to_uint(value);
+    }
+    else if (key == "seconds")
+    {
+        opt.bm_mode = mode_t::Time;
+        opt.seconds = to_uint(value);
+        opt.num_ops = std::numeric_limits<int64_t>::max();
+    }
+    else if (key == "sampling_ms")
+        opt.sampling_ms = to_double(value);
+    else if (key == "latency_sampling")
+        opt.latency_sampling = to_double(value);
+    else if (key == "rate")
+        opt.rate = to_double(value);
+    else if (key == "arrival")
+    {
+        if (!parse_arrival(value, opt.arrival))
+            throw std::invalid_argument("invalid arrival '" + value + "'");
+    }
+    else if (key == "batch_size")
+        opt.batch_size = to_uint(value);
+    else if (key == "interleave")
+        opt.interleave = to_uint(value);
+    else if (key == "record_trace")
+        opt.record_trace = value;
+    else if (key == "replay_trace")
+        opt.replay_trace = value;
+    else
+        throw std::invalid_argument("unknown key '" + key + "'");
+}
+
+} // namespace
+
+std::vector<phase_t> parse_workload(std::istream& in, const options_t& base)
+{
+    std::vector<phase_t> phases;
+    bool ratios_set = false;
+    bool keys_set = false;
+
+    std::string line;
+    for (uint64_t line_no = 1; std::getline(in, line); ++line_no)
+    {
+        auto error = [&](const std::string& msg)
+        {
+            return std::invalid_argument("line " + std::to_string(line_no) + ": " + msg);
+        };
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';')
+            continue;
+
+        if (line.front() == '[')
+        {
+            if (line.back() != ']')
+                throw error("missing ']' in phase name");
+
+            phases.push_back(phase_t{trim(line.substr(1, line.size() - 2)), base});
+            ratios_set = false;
+            keys_set = false;
+            continue;
+        }
+
+        if (phases.empty())
+            throw error("option outside of a phase");
+
+        auto sep = line.find('=');
+        if (sep == std::string::npos)
+            throw error("expected 'key = value'");
+
+        auto key = trim(line.substr(0, sep));
+        auto value = trim(line.substr(sep + 1));
+
+        // A preset overwrites the ratios and distribution set before it
+        if (key == "workload" && keys_set)
+            throw error("workload must be the first key of a phase");
+        keys_set = true;
+
+        try
+        {
+            set_option(phases.back(), ratios_set, key, value);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            throw error(e.what());
+        }
+    }
+
+    if (phases.empty())
+        throw std::invalid_argument("no phases defined");
+
+    return phases;
+}
+
+std::vector<phase_t> parse_workload_file(const std::string& path, const options_t& base)
+{
+    std::ifstream in(path);
+    if (!in.good())
+        throw std::invalid_argument("could not open '" + path + "'");
+
+    return parse_workload(in, base);
+}
+
+} // namespace PiBench
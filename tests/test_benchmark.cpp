@@ -0,0 +1,319 @@
+#include "gtest/gtest.h"
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace PiBench;
+
+namespace
+{
+
+// Tree that is never called, for benchmark_t helpers that do not touch it.
+class null_tree : public tree_api
+{
+public:
+    bool find(const char*, size_t, char*) override { return false; }
+    bool insert(const char*, size_t, const char*, size_t) override { return false; }
+    bool update(const char*, size_t, const char*, size_t) override { return false; }
+    bool remove(const char*, size_t) override { return false; }
+    int scan(const char*, size_t, int, char*&) override { return 0; }
+};
+
+options_t SortOptions(uint32_t threads, key_order_t order)
+{
+    options_t opt;
+    opt.enable_pcm = false;
+    opt.num_records = 1000;
+    opt.num_threads = threads;
+    opt.key_order = order;
+    opt.key_encoding = key_encoding_t::BIGENDIAN;
+    return opt;
+}
+
+TEST(BenchmarkTest, SortRecordsSequential)
+{
+    // Sorted keys are the ids [1, num_records] in order, with runs of
+    // uneven counts merged (thread counts that are not powers of two)
+    for (uint32_t threads : {1, 2, 3, 5})
+    {
+        null_tree tree;
+        benchmark_t bench(&tree, SortOptions(threads, key_order_t::SEQUENTIAL));
+        std::vector<char> keys;
+        std::vector<const char*> sorted;
+        bench.sort_records({}, keys, sorted);
+
+        ASSERT_EQ(sorted.size(), 1000);
+        char expected[8];
+        for (uint64_t i = 0; i < sorted.size(); ++i)
+        {
+            key_generator_t::store_id(i + 1, expected, 8, key_encoding_t::BIGENDIAN);
+            ASSERT_EQ(memcmp(sorted[i], expected, 8), 0) << "threads " << threads << " position " << i;
+        }
+    }
+}
+
+TEST(BenchmarkTest, SortRecordsHashed)
+{
+    // Hashed keys come out in memcmp order, each record exactly once
+    for (uint32_t threads : {1, 3})
+    {
+        null_tree tree;
+        benchmark_t bench(&tree, SortOptions(threads, key_order_t::HASHED));
+        std::vector<char> keys;
+        std::vector<const char*> sorted;
+        bench.sort_records({}, keys, sorted);
+
+        ASSERT_EQ(sorted.size(), 1000);
+        auto less = [](const char* a, const char* b) { return memcmp(a, b, 8) < 0; };
+        EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), less));
+
+        // Same keys as hashing ids [1, num_records] directly
+        uniform_key_generator_t gen(1000, 8);
+        gen.set_encoding(key_encoding_t::BIGENDIAN);
+        std::vector<char> expected(1000 * 8);
+        std::vector<const char*> generated;
+        for (uint64_t i = 0; i < 1000; ++i)
+        {
+            memcpy(&expected[i * 8], gen.hash_id(i + 1), 8);
+            generated.push_back(&expected[i * 8]);
+        }
+        std::sort(generated.begin(), generated.end(), less);
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            ASSERT_EQ(memcmp(sorted[i], generated[i], 8), 0);
+            if (i > 0)
+            {
+                ASSERT_NE(memcmp(sorted[i - 1], sorted[i], 8), 0);
+            }
+        }
+    }
+}
+
+std::vector<thread_stats_t> Inserted(std::initializer_list<uint64_t> counts)
+{
+    std::vector<thread_stats_t> stats(counts.size());
+    size_t t = 0;
+    for (auto count : counts)
+    {
+        for (uint64_t i = 0; i < count; ++i)
+            stats[t].record(operation_t::INSERT, true);
+        ++t;
+    }
+    return stats;
+}
+
+TEST(BenchmarkTest, InsertFrontier)
+{
+    // Nothing inserted yet: the records loaded before the run
+    EXPECT_EQ(insert_frontier(101, Inserted({0, 0, 0})), 100);
+    EXPECT_EQ(insert_frontier(1, Inserted({0, 0})), 0);
+
+    // Thread t inserts ids 101 + t, 104 + t, ...
+    EXPECT_EQ(insert_frontier(101, Inserted({2, 2, 2})), 106);
+    EXPECT_EQ(insert_frontier(101, Inserted({3, 2, 2})), 107);
+    EXPECT_EQ(insert_frontier(101, Inserted({3, 3, 2})), 108);
+
+    // Ids inserted by threads after a gap are not dense yet
+    EXPECT_EQ(insert_frontier(101, Inserted({2, 3, 3})), 106);
+    EXPECT_EQ(insert_frontier(101, Inserted({5, 0, 9})), 101);
+
+    EXPECT_EQ(insert_frontier(1, Inserted({4})), 4);
+}
+
+TEST(BenchmarkTest, LatestId)
+{
+    EXPECT_EQ(latest_id(1, 10), 10);
+    EXPECT_EQ(latest_id(10, 10), 1);
+
+    // Older ranks wrap around to the newest records
+    EXPECT_EQ(latest_id(11, 10), 1);
+    EXPECT_EQ(latest_id(12, 10), 2);
+    EXPECT_EQ(latest_id(25, 10), 5);
+
+    // Newest record unknown
+    EXPECT_EQ(latest_id(7, 0), 7);
+}
+
+// Pearson correlation of uniform key ids and uniform values drawn from
+// another stream of the same thread.
+double StreamCorrelation(uint32_t tid, random_stream_t stream)
+{
+    xoshiro256pp_engine key_gen(stream_seed(1729, tid, random_stream_t::KEY));
+    xoshiro256pp_engine other_gen(stream_seed(1729, tid, stream));
+    std::uniform_int_distribution<uint64_t> key_dist(1, 1000000);
+    std::uniform_int_distribution<uint32_t> other_dist(1, 100);
+
+    const int n = 20000;
+    double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        double x = key_dist(key_gen);
+        double y = other_dist(other_gen);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        syy += y * y;
+        sxy += x * y;
+    }
+    return (n * sxy - sx * sy) / std::sqrt((n * sxx - sx * sx) * (n * syy - sy * sy));
+}
+
+TEST(BenchmarkTest, StreamSeeds)
+{
+    // Keys keep their seed
+    EXPECT_EQ(stream_seed(1729, 2, random_stream_t::KEY), 1729 * 3);
+
+    // Scan lengths are not a function of the keys
+    for (uint32_t tid = 0; tid < 4; ++tid)
+    {
+        EXPECT_NE(stream_seed(1729, tid, random_stream_t::SCAN), stream_seed(1729, tid, random_stream_t::KEY));
+        EXPECT_LT(std::abs(StreamCorrelation(tid, random_stream_t::SCAN)), 0.05) << "thread " << tid;
+    }
+
+    // Nor are inter-arrival times
+    for (uint32_t tid = 0; tid < 4; ++tid)
+    {
+        EXPECT_NE(stream_seed(1729, tid, random_stream_t::ARRIVAL), stream_seed(1729, tid, random_stream_t::KEY));
+        EXPECT_NE(stream_seed(1729, tid, random_stream_t::ARRIVAL), stream_seed(1729, tid, random_stream_t::SCAN));
+        EXPECT_LT(std::abs(StreamCorrelation(tid, random_stream_t::ARRIVAL)), 0.05) << "thread " << tid;
+    }
+
+    // Nor are random moves of the hot set
+    EXPECT_NE(stream_seed(1729, 0, random_stream_t::HOT_SET), stream_seed(1729, 0, random_stream_t::KEY));
+    EXPECT_LT(std::abs(StreamCorrelation(0, random_stream_t::HOT_SET)), 0.05);
+
+    // Threads do not share streams
+    EXPECT_NE(stream_seed(1729, 0, random_stream_t::SCAN), stream_seed(1729, 1, random_stream_t::SCAN));
+}
+
+// Tree whose lookups take between 1 and max_steps steps depending on the key,
+// so interleaved lookups complete out of order. Keys with an odd last Byte
+// are reported missing. Lookups check their key is left alone while in
+// flight and that they complete exactly once.
+class stepping_tree : public tree_api
+{
+public:
+    explicit stepping_tree(int max_steps) : max_steps_(max_steps) {}
+
+    bool find(const char* key, size_t key_sz, char* value_out) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = records_.find(std::string(key, key_sz));
+        if (it == records_.end())
+            return false;
+        memcpy(value_out, it->second.data(), it->second.size());
+        return true;
+    }
+
+    bool insert(const char* key, size_t key_sz, const char* value, size_t value_sz) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_.emplace(std::string(key, key_sz), std::string(value, value_sz)).second;
+    }
+
+    bool update(const char*, size_t, const char*, size_t) override { return false; }
+    bool remove(const char*, size_t) override { return false; }
+    int scan(const char*, size_t, int, char*&) override { return 0; }
+
+    size_t find_state_size() const override { return sizeof(state_t); }
+
+    void find_start(void* state, const char* key, size_t key_sz, char* value_out) override
+    {
+        auto s = new (state) state_t{key, key_sz, value_out, std::string(key, key_sz), 0};
+        s->steps_left = 1 + static_cast<unsigned char>(key[0]) % max_steps_;
+        ++started;
+    }
+
+    bool find_step(void* state, bool& found) override
+    {
+        auto s = static_cast<state_t*>(state);
+        if (s->steps_left <= 0 || s->key_copy != std::string(s->key, s->key_sz))
+        {
+            ++errors;
+            found = false;
+            return true;
+        }
+        if (--s->steps_left > 0)
+            return false;
+
+        found = (s->key[s->key_sz - 1] & 1) == 0 && find(s->key, s->key_sz, s->value_out);
+        if (found)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& value = records_.at(s->key_copy);
+            if (memcmp(s->value_out, value.data(), value.size()) != 0)
+                ++errors;
+            ++expected_found;
+        }
+        s->~state_t();
+        new (state) state_t{};
+        ++completed;
+        return true;
+    }
+
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> expected_found{0};
+    std::atomic<uint64_t> errors{0};
+
+private:
+    struct state_t
+    {
+        const char* key;
+        size_t key_sz;
+        char* value_out;
+        std::string key_copy;
+        int steps_left;
+    };
+
+    const int max_steps_;
+    std::mutex mutex_;
+    std::map<std::string, std::string> records_;
+};
+
+TEST(BenchmarkTest, InterleavedMultiStepFind)
+{
+    // Every lookup is started once, stepped until it completes, and
+    // accounted for once, including those drained at the end of the run
+    auto seed = key_generator_t::get_seed();
+    for (uint32_t threads : {1, 2})
+    {
+        for (uint32_t interleave : {2, 5, 16})
+        {
+            stepping_tree tree(7);
+            options_t opt;
+            opt.enable_pcm = false;
+            opt.num_records = 2000;
+            opt.num_ops = 10007;
+            opt.num_threads = threads;
+            opt.interleave = interleave;
+            opt.latency_sampling = 0.1;
+            benchmark_t bench(&tree, opt);
+            bench.load();
+            auto result = bench.run();
+
+            auto reads = result.total.completed[static_cast<size_t>(operation_t::READ)];
+            auto found = result.total.succeeded[static_cast<size_t>(operation_t::READ)];
+            EXPECT_EQ(tree.errors, 0) << threads << " threads, interleave " << interleave;
+            EXPECT_EQ(tree.started, opt.num_ops);
+            EXPECT_EQ(tree.completed, opt.num_ops);
+            EXPECT_EQ(reads, opt.num_ops);
+            EXPECT_EQ(found, tree.expected_found);
+            EXPECT_GT(found, 0);
+            EXPECT_LT(found, opt.num_ops);
+        }
+    }
+
+    // The run seeds the key generators of its threads, this one included
+    key_generator_t::set_seed(seed);
+}
+
+}  // namespace
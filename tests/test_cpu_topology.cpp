@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "cpu_topology.hpp"
+
+using namespace PiBench;
+
+namespace
+{
+
+// Two sockets with two cores each, two SMT siblings per core. Siblings are
+// numbered the way Linux usually does: cpu N and N+4 share a core.
+std::vector<cpu_t> TwoSockets()
+{
+    std::vector<cpu_t> cpus;
+    for (uint32_t id = 0; id < 8; ++id)
+    {
+        cpu_t cpu;
+        cpu.id = id;
+        cpu.socket = (id % 4) / 2;
+        cpu.node = cpu.socket;
+        cpu.core = id % 2;
+        cpu.sibling = id / 4;
+        cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+TEST(CpuTopologyTest, ParseCpuList)
+{
+    std::vector<uint32_t> cpus;
+    ASSERT_TRUE(parse_cpu_list("0-3,8, 10-11", cpus));
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11}));
+
+    ASSERT_TRUE(parse_cpu_list("5,1", cpus));
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{5, 1}));
+
+    EXPECT_FALSE(parse_cpu_list("", cpus));
+    EXPECT_FALSE(parse_cpu_list("3-1", cpus));
+    EXPECT_FALSE(parse_cpu_list("1,,2", cpus));
+    EXPECT_FALSE(parse_cpu_list("a", cpus));
+}
+
+TEST(CpuTopologyTest, Compact)
+{
+    auto cpus = place_threads(TwoSockets(), affinity_t::COMPACT, 8, {});
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{0, 4, 1, 5, 2, 6, 3, 7}));
+}
+
+TEST(CpuTopologyTest, Scatter)
+{
+    auto cpus = place_threads(TwoSockets(), affinity_t::SCATTER, 8, {});
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{0, 2, 1, 3, 4, 6, 5, 7}));
+}
+
+TEST(CpuTopologyTest, Cores)
+{
+    auto cpus = place_threads(TwoSockets(), affinity_t::CORES, 8, {});
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST(CpuTopologyTest, ListWrapsAround)
+{
+    auto cpus = place_threads(TwoSockets(), affinity_t::LIST, 5, {6, 2});
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{6, 2, 6, 2, 6}));
+}
+
+TEST(CpuTopologyTest, MonitorAvoidsWorkerCores)
+{
+    auto topology = TwoSockets();
+
+    // Core of cpus 3 and 7 is free
+    EXPECT_EQ(pick_monitor_cpu(topology, {0, 1, 2}), 7);
+
+    // Only SMT siblings of workers are left
+    EXPECT_EQ(pick_monitor_cpu(topology, {0, 1, 2, 3}), 7);
+
+    // Every CPU runs a worker
+    EXPECT_EQ(pick_monitor_cpu(topology, {0, 1, 2, 3, 4, 5, 6, 7}), -1);
+}
+
+TEST(CpuTopologyTest, NumaNodes)
+{
+    EXPECT_EQ(numa_nodes(TwoSockets()), (std::vector<uint32_t>{0, 1}));
+}
+
+TEST(CpuTopologyTest, ParseMempolicy)
+{
+    mempolicy_t policy;
+    ASSERT_TRUE(parse_mempolicy("Interleave", policy));
+    EXPECT_EQ(policy, mempolicy_t::INTERLEAVE);
+    ASSERT_TRUE(parse_mempolicy("bind", policy));
+    EXPECT_EQ(policy, mempolicy_t::BIND);
+    EXPECT_FALSE(parse_mempolicy("preferred", policy));
+}
+
+}  // namespace
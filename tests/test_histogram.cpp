@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace PiBench;
+
+namespace
+{
+
+TEST(HistogramTest, Empty)
+{
+    histogram_t h;
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 0);
+    EXPECT_EQ(h.percentile(0.5), 0);
+}
+
+TEST(HistogramTest, SmallValuesAreExact)
+{
+    histogram_t h;
+    for (uint64_t v = 1; v <= 100; ++v)
+        h.record(v);
+
+    EXPECT_EQ(h.count(), 100);
+    EXPECT_EQ(h.min(), 1);
+    EXPECT_EQ(h.max(), 100);
+    EXPECT_EQ(h.percentile(0.5), 51);
+    EXPECT_EQ(h.percentile(0.9), 91);
+    EXPECT_EQ(h.percentile(1.0), 100);
+    EXPECT_DOUBLE_EQ(h.mean(), 50.5);
+}
+
+TEST(HistogramTest, RelativeError)
+{
+    std::default_random_engine gen(1729);
+    std::lognormal_distribution<double> dist(8.0, 2.0);
+
+    histogram_t h;
+    std::vector<uint64_t> values;
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        uint64_t v = dist(gen);
+        values.push_back(v);
+        h.record(v);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (double p : {0.5, 0.9, 0.99, 0.999, 0.9999})
+    {
+        double expected = values[p * values.size()];
+        double error = 1.0 / histogram_t::SUB_COUNT;
+        EXPECT_NEAR(h.percentile(p), expected, expected * error + 1) << "percentile " << p;
+    }
+    EXPECT_EQ(h.min(), values.front());
+    EXPECT_EQ(h.max(), values.back());
+}
+
+TEST(HistogramTest, LargeValues)
+{
+    histogram_t h;
+    uint64_t huge = 1ull << 50;
+    h.record(10);
+    h.record(huge);
+
+    EXPECT_EQ(h.count(), 2);
+    EXPECT_EQ(h.percentile(0.0), 10);
+    EXPECT_EQ(h.percentile(1.0), huge);
+    EXPECT_EQ(h.max(), huge);
+}
+
+TEST(HistogramTest, Merge)
+{
+    histogram_t a, b;
+    for (uint64_t v = 1; v <= 50; ++v)
+        a.record(v);
+    for (uint64_t v = 51; v <= 100; ++v)
+        b.record(v);
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 100);
+    EXPECT_EQ(a.min(), 1);
+    EXPECT_EQ(a.max(), 100);
+    EXPECT_EQ(a.percentile(0.5), 51);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0);
+}
+
+}  // namespace
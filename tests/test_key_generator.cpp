@@ -2,9 +2,12 @@
 #include "key_generator.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 using namespace PiBench;
 
@@ -172,4 +175,281 @@ TYPED_TEST(KeyGeneratorTest, ResetSeed)
     EXPECT_EQ(key1, key2);
 }
 
+TYPED_TEST(KeyGeneratorTest, Batched)
+{
+    // Batched keys are the same as keys generated one at a time
+    auto gen = this->Instantiate(1000, 8);
+    gen->set_seed(1729);
+    std::vector<uint64_t> expected;
+    for (size_t i = 0; i < 3 * key_generator_t::BATCH_SIZE + 5; ++i)
+        expected.push_back(*reinterpret_cast<const uint64_t*>(gen->next(false)));
+
+    gen->set_seed(1729);
+    for (size_t i = 0; i < expected.size(); ++i)
+        EXPECT_EQ(*reinterpret_cast<const uint64_t*>(gen->next_batched()), expected[i]);
+}
+
+TEST(KeyGeneratorBatchTest, HashIds)
+{
+    // Specialized and generic paths give the same keys as hash_id(). The
+    // prefix lives in a per-thread buffer, so generators are created in turn.
+    for (size_t size : {8, 12})
+    {
+        auto gen = std::make_unique<uniform_key_generator_t>(100, size, size == 8 ? "" : "user_");
+        uint64_t ids[] = {1, 2, 3, 42, 99, 100};
+        char keys[6 * key_generator_t::KEY_MAX];
+        gen->hash_ids(ids, 6, keys);
+        for (size_t i = 0; i < 6; ++i)
+            EXPECT_EQ(memcmp(&keys[i * gen->size()], gen->hash_id(ids[i]), gen->size()), 0);
+    }
+}
+
+TEST(KeyGeneratorBatchTest, Xoshiro256pp)
+{
+    // Same seed, same sequence
+    xoshiro256pp_engine a(1729), b(1729), c(1730);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(a(), b());
+
+    b.seed(1729);
+    a.seed(1729);
+    a.discard(10);
+    for (int i = 0; i < 10; ++i)
+        b();
+    EXPECT_EQ(a(), b());
+}
+
+TEST(ZipfianDistributionTest, Frequencies)
+{
+    // Observed frequencies of ranks match 1/k^theta, also for theta >= 1
+    const uint64_t n = 10;
+    const int samples = 200000;
+    for (double theta : {0.0, 0.5, 0.99, 1.0, 1.5})
+    {
+        zipfian_int_distribution<uint64_t> dist(1, n, theta);
+        xoshiro256pp_engine engine(1729);
+        std::vector<int> counts(n + 1, 0);
+        for (int i = 0; i < samples; ++i)
+        {
+            auto k = dist(engine);
+            ASSERT_GE(k, 1);
+            ASSERT_LE(k, n);
+            ++counts[k];
+        }
+
+        double zeta = 0.0;
+        for (uint64_t k = 1; k <= n; ++k)
+            zeta += std::pow(1.0 / k, theta);
+        for (uint64_t k = 1; k <= n; ++k)
+            EXPECT_NEAR(counts[k] / double(samples), std::pow(1.0 / k, theta) / zeta, 0.01) << "theta " << theta << " rank " << k;
+    }
+}
+
+TEST(ZipfianDistributionTest, HugeRange)
+{
+    // Constant setup cost, samples stay in range
+    zipfian_int_distribution<uint64_t> dist(1, 1ull << 40, 0.99);
+    xoshiro256pp_engine engine(1729);
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto k = dist(engine);
+        EXPECT_GE(k, 1);
+        EXPECT_LE(k, 1ull << 40);
+    }
+}
+
+TEST(ZipfianKeyGeneratorTest, Scrambled)
+{
+    // Ranks are permuted: ids stay in range, and the hottest id is not 1
+    const uint64_t n = 1000;
+    scrambled_zipfian_key_generator_t gen(n, 8, "", 0.99);
+    gen.set_seed(1729);
+    std::vector<int> counts(n + 1, 0);
+    for (int i = 0; i < 100000; ++i)
+    {
+        auto id = gen.next_id();
+        ASSERT_GE(id, 1);
+        ASSERT_LE(id, n);
+        ++counts[id];
+    }
+    auto hottest = std::max_element(counts.begin(), counts.end()) - counts.begin();
+    EXPECT_NE(hottest, 1);
+    EXPECT_GT(counts[hottest], 100000 / 20);
+}
+
+TEST(ZipfianKeyGeneratorTest, ClusteredRanks)
+{
+    // Ranks follow key order: the first ranks are adjacent keys
+    clustered_zipfian_key_generator_t gen(10, 8);
+    gen.set_order(key_order_t::MONOTONIC, 1, 2);
+    std::vector<uint64_t> keys;
+    for (uint64_t rank = 1; rank <= 10; ++rank)
+        keys.push_back(gen.order_id(gen.key_rank_id(rank)));
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_EQ(gen.key_rank_id(1), 1);
+    EXPECT_EQ(gen.key_rank_id(2), 3);
+    EXPECT_EQ(gen.key_rank_id(6), 2);
+
+    gen.set_order(key_order_t::SEQUENTIAL);
+    EXPECT_EQ(gen.key_rank_id(7), 7);
+}
+
+TEST(HotspotKeyGeneratorTest, HotSetShare)
+{
+    // 80% of the ids within the first 10% of the keyspace
+    const uint64_t n = 1000;
+    hotspot_key_generator_t gen(n, 8, "", 0.1, 0.8);
+    gen.set_seed(1729);
+    EXPECT_EQ(gen.hot_size(), 100);
+    int hot = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        auto id = gen.next_id();
+        ASSERT_GE(id, 1);
+        ASSERT_LE(id, n);
+        hot += id <= 100;
+    }
+    EXPECT_NEAR(hot / 100000.0, 0.8, 0.01);
+}
+
+TEST(HotspotKeyGeneratorTest, MovedHotSetWraps)
+{
+    // Hot set [951, 1000] and [1, 50], no cold ids drawn
+    const uint64_t n = 1000;
+    hotspot_key_generator_t gen(n, 8, "", 0.1, 1.0);
+    gen.set_hot_start(n + 950);
+    EXPECT_EQ(gen.hot_start(), 950);
+    std::vector<uint64_t> ids(10000);
+    gen.next_ids(ids.data(), ids.size());
+    for (auto id : ids)
+        ASSERT_TRUE(id > 950 || id <= 50) << id;
+}
+
+TEST(KeyGeneratorSmallKeysTest, Unique)
+{
+    // Every key width must hold as many distinct keys as it can represent
+    for (size_t size = 1; size <= 2; ++size)
+    {
+        uint64_t keyspace = 1ull << (size * 8);
+        uniform_key_generator_t gen(keyspace, size);
+        std::unordered_set<uint64_t> keys;
+        for (uint64_t id = 1; id <= keyspace; ++id)
+        {
+            uint64_t key = 0;
+            memcpy(&key, gen.hash_id(id), size);
+            EXPECT_TRUE(keys.insert(key).second);
+        }
+    }
+
+    uniform_key_generator_t gen(100000, 5);
+    std::unordered_set<uint64_t> keys;
+    for (uint64_t id = 1; id <= 100000; ++id)
+    {
+        uint64_t key = 0;
+        memcpy(&key, gen.hash_id(id), 5);
+        EXPECT_TRUE(keys.insert(key).second);
+    }
+}
+
+TEST(KeyGeneratorSmallKeysTest, FeistelPermutation)
+{
+    std::unordered_set<uint64_t> values;
+    for (uint64_t x = 0; x < (1 << 12); ++x)
+    {
+        uint64_t y = utils::feistel_permute(x, 12);
+        EXPECT_LT(y, 1 << 12);
+        EXPECT_TRUE(values.insert(y).second);
+    }
+
+    // Different keys give different permutations
+    EXPECT_NE(utils::feistel_permute(1, 32, 1), utils::feistel_permute(1, 32, 2));
+}
+
+TEST(KeyEncodingTest, BigEndian)
+{
+    char key[16];
+    key_generator_t::store_id(0x0102030405060708ull, key, 8, key_encoding_t::BIGENDIAN);
+    EXPECT_EQ(memcmp(key, "\x01\x02\x03\x04\x05\x06\x07\x08", 8), 0);
+
+    // Narrow keys keep the low Bytes, wide keys are padded with leading zeroes
+    key_generator_t::store_id(0x0102030405060708ull, key, 3, key_encoding_t::BIGENDIAN);
+    EXPECT_EQ(memcmp(key, "\x06\x07\x08", 3), 0);
+    key_generator_t::store_id(0x0102030405060708ull, key, 10, key_encoding_t::BIGENDIAN);
+    EXPECT_EQ(memcmp(key, "\x00\x00\x01\x02\x03\x04\x05\x06\x07\x08", 10), 0);
+}
+
+TEST(KeyEncodingTest, MemcmpOrderIsNumericOrder)
+{
+    uniform_key_generator_t gen(1000, 8, "user_");
+    gen.set_order(key_order_t::SEQUENTIAL);
+    gen.set_encoding(key_encoding_t::BIGENDIAN);
+
+    std::string last(gen.hash_id(1), 13);
+    for (uint64_t id = 2; id <= 1000; ++id)
+    {
+        std::string key(gen.hash_id(id), 13);
+        EXPECT_LT(memcmp(last.data(), key.data(), key.size()), 0);
+        last = key;
+    }
+}
+
+TEST(KeyOrderTest, Sequential)
+{
+    uniform_key_generator_t gen(100, 8);
+    gen.set_order(key_order_t::SEQUENTIAL);
+    for (uint64_t id = 1; id <= 100; ++id)
+        EXPECT_EQ(gen.order_id(id), id);
+}
+
+TEST(KeyOrderTest, Reverse)
+{
+    uniform_key_generator_t gen(100, 4);
+    gen.set_order(key_order_t::REVERSE);
+    for (uint64_t id = 1; id < 100; ++id)
+    {
+        uint32_t key1 = *reinterpret_cast<const uint32_t*>(gen.hash_id(id));
+        uint32_t key2 = *reinterpret_cast<const uint32_t*>(gen.hash_id(id + 1));
+        EXPECT_GT(key1, key2);
+    }
+}
+
+TEST(KeyOrderTest, KSorted)
+{
+    const uint64_t k = 10;
+    uniform_key_generator_t gen(100, 8);
+    gen.set_order(key_order_t::KSORTED, k);
+
+    std::unordered_set<uint64_t> keys;
+    for (uint64_t id = 1; id <= 100; ++id)
+    {
+        uint64_t key = gen.order_id(id);
+        EXPECT_LT(key > id ? key - id : id - key, k);
+        EXPECT_TRUE(keys.insert(key).second);
+    }
+
+    // Every block of k ids is a permutation of itself
+    for (uint64_t key = 1; key <= 100; ++key)
+        EXPECT_EQ(keys.count(key), 1);
+}
+
+TEST(KeyOrderTest, Monotonic)
+{
+    uniform_key_generator_t gen(100, 2);
+    gen.set_order(key_order_t::MONOTONIC, 1, 4);
+
+    // Ids dealt round-robin, stream s holds ids s+1, s+5, ...
+    uint64_t last[4] = {0, 0, 0, 0};
+    for (uint64_t id = 1; id <= 100; ++id)
+    {
+        uint64_t s = (id - 1) % 4;
+        uint64_t key = *reinterpret_cast<const uint16_t*>(gen.hash_id(id));
+        EXPECT_GT(key, last[s]);
+        EXPECT_GE(key, s * (1 << 14));
+        EXPECT_LT(key, (s + 1) * (1 << 14));
+        last[s] = key;
+    }
+}
+
 }  // namespace
@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include "result_writer.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace PiBench;
+
+namespace
+{
+
+result_t MakeResult()
+{
+    result_t r;
+    r.name = "phase \"one\"";
+    r.elapsed_ms = 2000;
+    r.total.operation_count = 100;
+    r.total.completed[static_cast<size_t>(operation_t::READ)] = 100;
+    r.total.succeeded[static_cast<size_t>(operation_t::READ)] = 80;
+
+    stats_t window;
+    window.operation_count = 100;
+    window.completed[static_cast<size_t>(operation_t::READ)] = 100;
+    window.succeeded[static_cast<size_t>(operation_t::READ)] = 80;
+    r.samples.push_back(window);
+    return r;
+}
+
+TEST(ResultWriterTest, ParseOutputFormat)
+{
+    output_format_t format;
+    EXPECT_TRUE(parse_output_format("JSON", format));
+    EXPECT_EQ(format, output_format_t::JSON);
+    EXPECT_TRUE(parse_output_format("csv", format));
+    EXPECT_EQ(format, output_format_t::CSV);
+    EXPECT_TRUE(parse_output_format("text", format));
+    EXPECT_EQ(format, output_format_t::TEXT);
+    EXPECT_FALSE(parse_output_format("xml", format));
+}
+
+TEST(ResultWriterTest, Json)
+{
+    environment_t env;
+    env.kernel = "Linux";
+
+    std::ostringstream os;
+    write_json(os, env, {MakeResult()});
+    auto json = os.str();
+
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_NE(json.find("\"kernel\": \"Linux\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\": \"phase \\\"one\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"completed\": 50"), std::string::npos);
+    EXPECT_NE(json.find("\"samples\": ["), std::string::npos);
+    EXPECT_EQ(json.find("\"latency\": {"), std::string::npos);
+    EXPECT_EQ(json.find("\"pcm\": {"), std::string::npos);
+}
+
+TEST(ResultWriterTest, Csv)
+{
+    std::ostringstream os;
+    write_csv(os, environment_t(), {MakeResult()});
+
+    std::istringstream in(os.str());
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "phase,section,operation,outcome,window,metric,value");
+
+    bool throughput = false;
+    bool sample = false;
+    while (std::getline(in, line))
+    {
+        EXPECT_EQ(std::count(line.begin(), line.end(), ','), 6) << line;
+        if (line == "\"phase \"\"one\"\"\",throughput,read,,,succeeded_per_second,40")
+            throughput = true;
+        if (line == "\"phase \"\"one\"\"\",sample,read,,0,succeeded,80")
+            sample = true;
+    }
+    EXPECT_TRUE(throughput);
+    EXPECT_TRUE(sample);
+}
+
+TEST(ResultWriterTest, Load)
+{
+    load_result_t load;
+    load.loaded = true;
+    load.records = 1000;
+    load.inserted = 1000;
+    load.elapsed_ms = 500;
+    load.sampling_ms = 250;
+    load.samples = {600, 400};
+    load.verified = true;
+    load.missing = 3;
+
+    std::ostringstream json;
+    write_json(json, environment_t(), {MakeResult()}, load);
+    EXPECT_NE(json.str().find("\"load\": {"), std::string::npos);
+    EXPECT_NE(json.str().find("\"records_per_second\": 2000"), std::string::npos);
+    EXPECT_NE(json.str().find("\"missing\": 3"), std::string::npos);
+
+    std::ostringstream csv;
+    write_csv(csv, environment_t(), {MakeResult()}, load);
+    EXPECT_NE(csv.str().find("load,sample,,,1,records,400"), std::string::npos);
+
+    // Nothing is written if the load was skipped
+    std::ostringstream skipped;
+    write_json(skipped, environment_t(), {MakeResult()});
+    EXPECT_EQ(skipped.str().find("\"load\": {"), std::string::npos);
+}
+
+}  // namespace
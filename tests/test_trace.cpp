@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include "trace.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace PiBench;
+
+namespace
+{
+
+std::string TempPath(const std::string& name)
+{
+    return "/tmp/pibench_test_" + name + "_" + std::to_string(::getpid()) + ".trace";
+}
+
+TEST(TraceTest, Partition)
+{
+    uint64_t first, last;
+    trace_partition(10, 3, 0, first, last);
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(last, 4);
+    trace_partition(10, 3, 1, first, last);
+    EXPECT_EQ(first, 4);
+    EXPECT_EQ(last, 7);
+    trace_partition(10, 3, 2, first, last);
+    EXPECT_EQ(first, 7);
+    EXPECT_EQ(last, 10);
+}
+
+TEST(TraceTest, WriteAndRead)
+{
+    auto path = TempPath("rw");
+    {
+        trace_writer_t writer(path, 4);
+        writer.append(operation_t::INSERT, "aaaa", 100, 0);
+        writer.append(operation_t::SCAN, "bbbb", 0, 50);
+
+        // Records written out of order by another thread
+        std::vector<char> records(2 * writer.record_size());
+        writer.encode(&records[0], operation_t::READ, "dddd", 0, 0);
+        writer.encode(&records[writer.record_size()], operation_t::UPDATE, "eeee", 100000, 0);
+        writer.write(3, records.data(), 2);
+
+        EXPECT_EQ(writer.close(), 5);
+    }
+
+    trace_reader_t reader(path);
+    ASSERT_EQ(reader.size(), 5);
+    EXPECT_EQ(reader.key_size(), 4);
+
+    auto r = reader.get(0);
+    EXPECT_EQ(r.op, operation_t::INSERT);
+    EXPECT_EQ(r.value_size, 100);
+    EXPECT_EQ(memcmp(r.key, "aaaa", 4), 0);
+
+    r = reader.get(1);
+    EXPECT_EQ(r.op, operation_t::SCAN);
+    EXPECT_EQ(r.scan_size, 50);
+
+    // Value size clamped to the format
+    r = reader.get(4);
+    EXPECT_EQ(r.op, operation_t::UPDATE);
+    EXPECT_EQ(r.value_size, 65535);
+
+    trace_cursor_t cursor(reader, 3, 5);
+    trace_request_t request;
+    ASSERT_TRUE(cursor.next(request));
+    EXPECT_EQ(memcmp(request.key, "dddd", 4), 0);
+    ASSERT_TRUE(cursor.next(request));
+    EXPECT_FALSE(cursor.next(request));
+
+    std::remove(path.c_str());
+}
+
+TEST(TraceTest, RejectsInvalidFiles)
+{
+    auto path = TempPath("invalid");
+    {
+        std::ofstream out(path);
+        out << "this is not a trace, but long enough to hold a header";
+    }
+    EXPECT_THROW(trace_reader_t reader(path), std::runtime_error);
+
+    // Header claims more records than the file holds
+    {
+        trace_writer_t writer(path, 8);
+        writer.append(operation_t::READ, "12345678", 0, 0);
+        writer.close();
+    }
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t records = 2;
+        f.seekp(offsetof(trace_header_t, num_records));
+        f.write(reinterpret_cast<const char*>(&records), sizeof(records));
+    }
+    EXPECT_THROW(trace_reader_t reader(path), std::runtime_error);
+
+    std::remove(path.c_str());
+    EXPECT_THROW(trace_reader_t reader(path), std::runtime_error);
+}
+
+TEST(TraceTest, ParseYcsb)
+{
+    char key[8];
+    trace_request_t r;
+
+    ASSERT_TRUE(parse_ycsb_request("READ usertable user42 [ <all fields>]", 8, r, key));
+    EXPECT_EQ(r.op, operation_t::READ);
+    uint64_t id;
+    memcpy(&id, key, sizeof(id));
+    EXPECT_EQ(id, 42);
+
+    ASSERT_TRUE(parse_ycsb_request("READ usertable user42 [ <all fields>]", 8, r, key, key_encoding_t::BIGENDIAN));
+    EXPECT_EQ(memcmp(key, "\0\0\0\0\0\0\0\x2a", 8), 0);
+
+    ASSERT_TRUE(parse_ycsb_request("INSERT usertable user7 [ field0=abc field1=d e ]", 8, r, key));
+    EXPECT_EQ(r.op, operation_t::INSERT);
+    EXPECT_EQ(r.value_size, 6);
+
+    ASSERT_TRUE(parse_ycsb_request("SCAN usertable user7 75 [ <all fields>]", 8, r, key));
+    EXPECT_EQ(r.op, operation_t::SCAN);
+    EXPECT_EQ(r.scan_size, 75);
+
+    ASSERT_TRUE(parse_ycsb_request("DELETE usertable abc", 8, r, key));
+    EXPECT_EQ(r.op, operation_t::REMOVE);
+    EXPECT_EQ(memcmp(key, "abc\0\0\0\0\0", 8), 0);
+
+    // Keys that do not fit, and lines that are not requests
+    EXPECT_FALSE(parse_ycsb_request("READ usertable a_very_long_key [ <all fields>]", 8, r, key));
+    EXPECT_FALSE(parse_ycsb_request("[OVERALL], RunTime(ms), 1234", 8, r, key));
+    EXPECT_FALSE(parse_ycsb_request("", 8, r, key));
+}
+
+TEST(TraceTest, ImportYcsb)
+{
+    std::istringstream in(
+        "Loading workload...\n"
+        "INSERT usertable user1 [ field0=abcd ]\n"
+        "READ usertable user1 [ <all fields>]\n"
+        "UPDATE usertable user2 [ field0=xy ]\n");
+
+    auto path = TempPath("import");
+    {
+        trace_writer_t writer(path, 8);
+        uint64_t skipped = 0;
+        EXPECT_EQ(import_ycsb(in, writer, skipped), 3);
+        EXPECT_EQ(skipped, 1);
+        writer.close();
+    }
+
+    trace_reader_t reader(path);
+    ASSERT_EQ(reader.size(), 3);
+    EXPECT_EQ(reader.get(0).value_size, 4);
+    EXPECT_EQ(reader.get(1).op, operation_t::READ);
+    EXPECT_EQ(reader.get(2).op, operation_t::UPDATE);
+    std::remove(path.c_str());
+}
+
+}  // namespace
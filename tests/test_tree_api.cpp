@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+#include "tree_api.hpp"
+#include "key_generator.hpp"
+#include "stlmap_wrapper.hpp"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Minimal tree that only implements the single-key operations, so the
+// batched ones fall back to the default implementations.
+class map_tree : public tree_api
+{
+public:
+    bool find(const char* key, size_t key_sz, char* value_out) override
+    {
+        auto it = map_.find(std::string(key, key_sz));
+        if (it == map_.end())
+            return false;
+        memcpy(value_out, it->second.data(), it->second.size());
+        return true;
+    }
+
+    bool insert(const char* key, size_t key_sz, const char* value, size_t value_sz) override
+    {
+        return map_.emplace(std::string(key, key_sz), std::string(value, value_sz)).second;
+    }
+
+    bool update(const char*, size_t, const char*, size_t) override { return false; }
+    bool remove(const char*, size_t) override { return false; }
+    int scan(const char*, size_t, int, char*&) override { return 0; }
+
+private:
+    std::map<std::string, std::string> map_;
+};
+
+TEST(TreeApiTest, DefaultMultiInsert)
+{
+    map_tree tree;
+    const char* keys[] = {"aaaa", "bbbb", "aaaa"};
+    const char* values[] = {"1111", "2222", "3333"};
+    bool inserted[3];
+
+    EXPECT_EQ(tree.multi_insert(3, keys, 4, values, 4, inserted), 2);
+    EXPECT_TRUE(inserted[0]);
+    EXPECT_TRUE(inserted[1]);
+    EXPECT_FALSE(inserted[2]);
+}
+
+TEST(TreeApiTest, DefaultBulkLoad)
+{
+    // Falls back to one insert per record
+    map_tree tree;
+    const char* keys[] = {"aaaa", "bbbb", "cccc"};
+    const char* values[] = {"1111", "2222", "3333"};
+
+    EXPECT_EQ(tree.bulk_load(2, keys, 4, values, 4), 2);
+    EXPECT_EQ(tree.bulk_load(1, keys + 2, 4, values + 2, 4), 1);
+
+    char value[4];
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(tree.find(keys[i], 4, value));
+        EXPECT_EQ(memcmp(value, values[i], 4), 0);
+    }
+}
+
+TEST(TreeApiTest, StlmapBulkLoadChunks)
+{
+    // Big-endian keys of ids [1, 100] loaded in two chunks
+    const uint64_t n = 100;
+    std::vector<char> buf(n * 8);
+    std::vector<const char*> keys(n);
+    std::vector<uint64_t> values(n);
+    std::vector<const char*> value_ptrs(n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        PiBench::key_generator_t::store_id(i + 1, &buf[i * 8], 8, PiBench::key_encoding_t::BIGENDIAN);
+        keys[i] = &buf[i * 8];
+        values[i] = i + 1;
+        value_ptrs[i] = reinterpret_cast<const char*>(&values[i]);
+    }
+
+    stlmap_wrapper<uint64_t, uint64_t> tree(true);
+    EXPECT_EQ(tree.bulk_load(60, keys.data(), 8, value_ptrs.data(), 8), 60);
+    EXPECT_EQ(tree.bulk_load(n - 60, keys.data() + 60, 8, value_ptrs.data() + 60, 8), n - 60);
+
+    // Scans return (key, value) pairs in numeric order of the ids
+    char* out = nullptr;
+    ASSERT_EQ(tree.scan(keys[0], 8, n, out), n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        uint64_t k, v;
+        memcpy(&k, out + i * 16, 8);
+        memcpy(&v, out + i * 16 + 8, 8);
+        EXPECT_EQ(k, i + 1);
+        EXPECT_EQ(v, i + 1);
+    }
+}
+
+TEST(TreeApiTest, DefaultMultiFind)
+{
+    map_tree tree;
+    tree.insert("aaaa", 4, "1111", 4);
+    tree.insert("cccc", 4, "3333", 4);
+
+    const char* keys[] = {"aaaa", "bbbb", "cccc"};
+    char buf[3][4];
+    char* values_out[] = {buf[0], buf[1], buf[2]};
+    bool found[3];
+
+    EXPECT_EQ(tree.multi_find(3, keys, 4, values_out, found), 2);
+    EXPECT_TRUE(found[0]);
+    EXPECT_FALSE(found[1]);
+    EXPECT_TRUE(found[2]);
+    EXPECT_EQ(memcmp(buf[0], "1111", 4), 0);
+    EXPECT_EQ(memcmp(buf[2], "3333", 4), 0);
+}
+
+TEST(TreeApiTest, DefaultInterleavedFind)
+{
+    map_tree tree;
+    tree.insert("aaaa", 4, "1111", 4);
+
+    std::vector<char> state(tree.find_state_size());
+    char value[4];
+    bool found = false;
+
+    tree.find_start(state.data(), "aaaa", 4, value);
+    EXPECT_TRUE(tree.find_step(state.data(), found));
+    EXPECT_TRUE(found);
+    EXPECT_EQ(memcmp(value, "1111", 4), 0);
+
+    tree.find_start(state.data(), "bbbb", 4, value);
+    EXPECT_TRUE(tree.find_step(state.data(), found));
+    EXPECT_FALSE(found);
+}
+
+}  // namespace
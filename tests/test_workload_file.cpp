@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+#include "workload_file.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace PiBench;
+
+namespace
+{
+
+std::vector<phase_t> Parse(const std::string& text, const options_t& base = options_t())
+{
+    std::istringstream in(text);
+    return parse_workload(in, base);
+}
+
+TEST(WorkloadFileTest, Phases)
+{
+    options_t base;
+    base.num_threads = 4;
+    base.scan_size = 50;
+
+    auto phases = Parse(
+        "# Production day\n"
+        "[read-heavy]\n"
+        "read_ratio = 0.95\n"
+        "update_ratio = 0.05\n"
+        "distribution = ZIPFIAN\n"
+        "skew = 0.99\n"
+        "seconds = 30\n"
+        "\n"
+        "[scan-heavy]\n"
+        "  scan_ratio=1.0\n"
+        "  scan_size = 1000\n"
+        "  threads = 8\n"
+        "  operations = 5000\n",
+        base);
+
+    ASSERT_EQ(phases.size(), 2);
+
+    EXPECT_EQ(phases[0].name, "read-heavy");
+    EXPECT_FLOAT_EQ(phases[0].opt.read_ratio, 0.95);
+    EXPECT_FLOAT_EQ(phases[0].opt.update_ratio, 0.05);
+    EXPECT_FLOAT_EQ(phases[0].opt.insert_ratio, 0.0);
+    EXPECT_EQ(phases[0].opt.key_distribution, distribution_t::ZIPFIAN);
+    EXPECT_FLOAT_EQ(phases[0].opt.key_skew, 0.99);
+    EXPECT_EQ(phases[0].opt.bm_mode, PiBench::mode_t::Time);
+    EXPECT_EQ(phases[0].opt.seconds, 30);
+    EXPECT_EQ(phases[0].opt.num_threads, 4);
+    EXPECT_EQ(phases[0].opt.scan_size, 50);
+
+    EXPECT_EQ(phases[1].name, "scan-heavy");
+    EXPECT_FLOAT_EQ(phases[1].opt.read_ratio, 0.0);
+    EXPECT_FLOAT_EQ(phases[1].opt.scan_ratio, 1.0);
+    EXPECT_EQ(phases[1].opt.scan_size, 1000);
+    EXPECT_EQ(phases[1].opt.num_threads, 8);
+    EXPECT_EQ(phases[1].opt.bm_mode, PiBench::mode_t::Operation);
+    EXPECT_EQ(phases[1].opt.num_ops, 5000);
+    EXPECT_EQ(phases[1].opt.key_distribution, distribution_t::UNIFORM);
+}
+
+TEST(WorkloadFileTest, InheritsBaseRatios)
+{
+    options_t base;
+    base.read_ratio = 0.5;
+    base.update_ratio = 0.5;
+
+    auto phases = Parse("[same mix]\nthreads = 2\n", base);
+    ASSERT_EQ(phases.size(), 1);
+    EXPECT_FLOAT_EQ(phases[0].opt.read_ratio, 0.5);
+    EXPECT_FLOAT_EQ(phases[0].opt.update_ratio, 0.5);
+}
+
+TEST(WorkloadFileTest, YcsbPresets)
+{
+    auto phases = Parse(
+        "[a]\nworkload = YCSB-A\n"
+        "[d]\nworkload = ycsb-d\n"
+        "[e]\nworkload = ycsb-e\nscan_size = 10\n"
+        "[f]\nworkload = ycsb-f\nread_ratio = 0.25\nrmw_ratio = 0.75\n");
+    ASSERT_EQ(phases.size(), 4);
+
+    EXPECT_FLOAT_EQ(phases[0].opt.read_ratio, 0.5);
+    EXPECT_FLOAT_EQ(phases[0].opt.update_ratio, 0.5);
+    EXPECT_EQ(phases[0].opt.key_distribution, distribution_t::ZIPFIAN);
+    EXPECT_FLOAT_EQ(phases[0].opt.key_skew, 0.99);
+    EXPECT_EQ(phases[0].opt.value_size, options_t().value_size);
+
+    EXPECT_FLOAT_EQ(phases[1].opt.insert_ratio, 0.05);
+    EXPECT_EQ(phases[1].opt.key_distribution, distribution_t::LATEST);
+
+    EXPECT_FLOAT_EQ(phases[2].opt.scan_ratio, 0.95);
+    EXPECT_EQ(phases[2].opt.scan_length, scan_length_t::UNIFORM);
+    EXPECT_EQ(phases[2].opt.scan_size, 10);
+
+    // Ratios given after the preset override it
+    EXPECT_FLOAT_EQ(phases[3].opt.read_ratio, 0.25);
+    EXPECT_FLOAT_EQ(phases[3].opt.rmw_ratio, 0.75);
+
+    EXPECT_THROW(Parse("[g]\nworkload = ycsb-g\n"), std::invalid_argument);
+
+    // A preset after other keys would silently overwrite them
+    try
+    {
+        Parse("[a]\nread_ratio = 0.25\nworkload = ycsb-a\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_EQ(std::string(e.what()), "line 3: workload must be the first key of a phase");
+    }
+
+    // Each phase starts over
+    EXPECT_EQ(Parse("[a]\nthreads = 2\n[b]\nworkload = ycsb-b\n").size(), 2);
+}
+
+TEST(WorkloadFileTest, Errors)
+{
+    EXPECT_THROW(Parse(""), std::invalid_argument);
+    EXPECT_THROW(Parse("read_ratio = 1.0\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a]\nread_ratio\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a]\nunknown = 1\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a]\nthreads = -1\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a]\nskew = abc\n"), std::invalid_argument);
+    EXPECT_THROW(Parse("[a]\ndistribution = normal\n"), std::invalid_argument);
+
+    try
+    {
+        Parse("[a]\n\noperations = 10x\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        EXPECT_EQ(std::string(e.what()), "line 3: invalid unsigned integer '10x'");
+    }
+}
+
+}  // namespace
@@ -50,11 +50,20 @@ public:
 	void print_stat(leveldb::DB* db_, bool print_sst=false);
 
 private:
+	// LevelDB orders keys by memcmp, so integer ids stored in host byte order
+	// are swapped (ids of big-endian keys are already in the right order).
+	uint64_t encode_key(const char* key) const {
+		uint64_t k = *reinterpret_cast<const uint64_t *>(key);
+		return swap_keys ? __builtin_bswap64(k) : k;
+	}
+
 	leveldb::DB* db;
 	leveldb::Options options;
+	bool swap_keys;
 };
 
-leveldb_wrapper::leveldb_wrapper(const tree_options_t& opt) {
+leveldb_wrapper::leveldb_wrapper(const tree_options_t& opt)
+	: swap_keys(!opt.big_endian_keys) {
 
 	// TODO(jhpark) : Provide specific wrapper options in Pibench command 
 	options.create_if_missing = true;
@@ -78,8 +87,9 @@ bool leveldb_wrapper::find(const char* key, size_t key_sz, char* value_out)
 {
 	// TODO(jhpark): Provide positive/false read statistics
 	std::string str;
-	uint64_t k = __builtin_bswap64(*reinterpret_cast<const uint64_t *>(key));
-  leveldb::Status s = db->Get(leveldb::ReadOptions(), reinterpret_cast<const char *>(&k), &str);
+	uint64_t k = encode_key(key);
+	leveldb::Slice k_slice(reinterpret_cast<const char *>(&k), sizeof(k));
+  leveldb::Status s = db->Get(leveldb::ReadOptions(), k_slice, &str);
 
 	if (s.ok()) {
 		std::vector<char> result(str.begin(), str.end());
@@ -93,8 +103,9 @@ bool leveldb_wrapper::find(const char* key, size_t key_sz, char* value_out)
 
 bool leveldb_wrapper::insert(const char* key, size_t key_sz, const char* value, size_t value_sz)
 {
-	uint64_t k = __builtin_bswap64(*reinterpret_cast<const uint64_t *>(key));
-	leveldb::Status s = db->Put(leveldb::WriteOptions(), reinterpret_cast<const char *>(&k), value);
+	uint64_t k = encode_key(key);
+	leveldb::Slice k_slice(reinterpret_cast<const char *>(&k), sizeof(k));
+	leveldb::Status s = db->Put(leveldb::WriteOptions(), k_slice, leveldb::Slice(value, value_sz));
 	
 	if (s.ok()) {
 		return true;
@@ -108,8 +119,9 @@ bool leveldb_wrapper::update(const char* key, size_t key_sz, const char* value,
 }
 
 bool leveldb_wrapper::remove(const char* key, size_t key_sz) {
-	uint64_t k = __builtin_bswap64(*reinterpret_cast<const uint64_t *>(key));
-  leveldb::Status s = db->Delete(leveldb::WriteOptions(), reinterpret_cast<const char *>(&k));
+	uint64_t k = encode_key(key);
+	leveldb::Slice k_slice(reinterpret_cast<const char *>(&k), sizeof(k));
+  leveldb::Status s = db->Delete(leveldb::WriteOptions(), k_slice);
 
 	if (s.ok()) {
 		return true;
@@ -125,12 +137,13 @@ int leveldb_wrapper::scan(const char* key, size_t key_sz, int scan_sz, char*& va
 	//	- Efficient scan algorithms needed
 
 	int scanned = 0;
-	uint64_t k = __builtin_bswap64(*reinterpret_cast<const uint64_t *>(key));
+	uint64_t k = encode_key(key);
+	leveldb::Slice k_slice(reinterpret_cast<const char *>(&k), sizeof(k));
 
  	static thread_local std::array<char, (1 << 20)> results;
 	char *dst = results.data();
 
-	for (iterator->Seek(key); (iterator->Valid() && scanned < scan_sz); iterator->Next()) {
+	for (iterator->Seek(k_slice); (iterator->Valid() && scanned < scan_sz); iterator->Next()) {
 
 		uint64_t result_key = reinterpret_cast<const uint64_t>(iterator->key().data());
 
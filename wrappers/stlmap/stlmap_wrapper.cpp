@@ -5,22 +5,22 @@ extern "C" tree_api* create_tree(const tree_options_t& opt)
     if (opt.key_size == 4)
     {
         if (opt.value_size == 4)
-            return new stlmap_wrapper<uint32_t, uint32_t>();
+            return new stlmap_wrapper<uint32_t, uint32_t>(opt.big_endian_keys);
         else if (opt.value_size == 8)
-            return new stlmap_wrapper<uint32_t, uint64_t>();
+            return new stlmap_wrapper<uint32_t, uint64_t>(opt.big_endian_keys);
         else if (opt.value_size > 8)
-            return new stlmap_wrapper<uint32_t, std::string>();
+            return new stlmap_wrapper<uint32_t, std::string>(opt.big_endian_keys);
         else
             return nullptr;// ERROR
     }
     else if (opt.key_size == 8)
     {
         if (opt.value_size == 4)
-            return new stlmap_wrapper<uint64_t, uint32_t>();
+            return new stlmap_wrapper<uint64_t, uint32_t>(opt.big_endian_keys);
         else if (opt.value_size == 8)
-            return new stlmap_wrapper<uint64_t, uint64_t>();
+            return new stlmap_wrapper<uint64_t, uint64_t>(opt.big_endian_keys);
         else if (opt.value_size > 8)
-            return new stlmap_wrapper<uint64_t, std::string>();
+            return new stlmap_wrapper<uint64_t, std::string>(opt.big_endian_keys);
         else
             return nullptr;// ERROR
 
@@ -16,7 +16,7 @@ template<typename Key, typename T>
 class stlmap_wrapper : public tree_api
 {
 public:
-    stlmap_wrapper();
+    explicit stlmap_wrapper(bool big_endian_keys = false);
     virtual ~stlmap_wrapper();
     
     virtual bool find(const char* key, size_t key_sz, char* value_out) override;
@@ -24,14 +24,28 @@ public:
     virtual bool update(const char* key, size_t key_sz, const char* value, size_t value_sz) override;
     virtual bool remove(const char* key, size_t key_sz) override;
     virtual int scan(const char* key, size_t key_sz, int scan_sz, char*& values_out) override;
+    virtual size_t multi_find(size_t num, const char* const* keys, size_t sz, char* const* values_out, bool* found) override;
+    virtual size_t multi_insert(size_t num, const char* const* keys, size_t key_sz,
+                                const char* const* values, size_t value_sz, bool* inserted) override;
+    virtual size_t bulk_load(size_t num, const char* const* keys, size_t key_sz,
+                             const char* const* values, size_t value_sz) override;
 
 private:
+    bool find_locked(const char* key, size_t key_sz, char* value_out);
+    bool insert_locked(const char* key, size_t key_sz, const char* value, size_t value_sz);
+    Key make_key(const char* key, size_t key_sz) const;
+    std::pair<Key,T> make_record(const char* key, size_t key_sz, const char* value, size_t value_sz) const;
+
     std::map<Key,T> map_;
     std::shared_mutex mutex_;
+
+    /// Integer keys are stored most significant Byte first.
+    bool big_endian_keys_;
 };
 
 template<typename Key, typename T>
-stlmap_wrapper<Key,T>::stlmap_wrapper()
+stlmap_wrapper<Key,T>::stlmap_wrapper(bool big_endian_keys)
+    : big_endian_keys_(big_endian_keys)
 {
 }
 
@@ -44,29 +58,35 @@ template<typename Key, typename T>
 bool stlmap_wrapper<Key,T>::find(const char* key, size_t key_sz, char* value_out)
 {
     std::shared_lock lock(mutex_);
+    return find_locked(key, key_sz, value_out);
+}
 
-    if constexpr (std::is_arithmetic<Key>::value)
-    {
-        auto it = map_.find(*reinterpret_cast<Key*>(const_cast<char*>(key)));
-        if (it == map_.end())
-            return false;
+template<typename Key, typename T>
+size_t stlmap_wrapper<Key,T>::multi_find(size_t num, const char* const* keys, size_t sz, char* const* values_out, bool* found)
+{
+    // The whole batch is served under a single lock acquisition
+    std::shared_lock lock(mutex_);
 
-        if constexpr (std::is_arithmetic<T>::value)
-            memcpy(value_out, &it->second, sizeof(T));
-        else
-            memcpy(value_out, it->second.c_str(), it->second.size());
-    }
-    else
+    size_t n = 0;
+    for (size_t i = 0; i < num; ++i)
     {
-        auto it = map_.find(std::string(key, key_sz));
-        if (it == map_.end())
-            return false;
-
-        if constexpr (std::is_arithmetic<T>::value)
-            memcpy(value_out, &it->second, sizeof(T));
-        else
-            memcpy(value_out, it->second.c_str(), it->second.size());
+        found[i] = find_locked(keys[i], sz, values_out[i]);
+        n += found[i];
     }
+    return n;
+}
+
+template<typename Key, typename T>
+bool stlmap_wrapper<Key,T>::find_locked(const char* key, size_t key_sz, char* value_out)
+{
+    auto it = map_.find(make_key(key, key_sz));
+    if (it == map_.end())
+        return false;
+
+    if constexpr (std::is_arithmetic<T>::value)
+        memcpy(value_out, &it->second, sizeof(T));
+    else
+        memcpy(value_out, it->second.c_str(), it->second.size());
     return true;
 }
 
@@ -75,12 +95,78 @@ template<typename Key, typename T>
 bool stlmap_wrapper<Key, T>::insert(const char* key, size_t key_sz, const char* value, size_t value_sz)
 {
     std::unique_lock lock(mutex_);
+    return insert_locked(key, key_sz, value, value_sz);
+}
+
+template<typename Key, typename T>
+size_t stlmap_wrapper<Key, T>::multi_insert(size_t num, const char* const* keys, size_t key_sz,
+                                            const char* const* values, size_t value_sz, bool* inserted)
+{
+    std::unique_lock lock(mutex_);
+
+    size_t n = 0;
+    for (size_t i = 0; i < num; ++i)
+    {
+        inserted[i] = insert_locked(keys[i], key_sz, values[i], value_sz);
+        n += inserted[i];
+    }
+    return n;
+}
+
+template<typename Key, typename T>
+bool stlmap_wrapper<Key, T>::insert_locked(const char* key, size_t key_sz, const char* value, size_t value_sz)
+{
+    return map_.insert(make_record(key, key_sz, value, value_sz)).second;
+}
+
+template<typename Key, typename T>
+size_t stlmap_wrapper<Key, T>::bulk_load(size_t num, const char* const* keys, size_t key_sz,
+                                         const char* const* values, size_t value_sz)
+{
+    std::unique_lock lock(mutex_);
+
+    // Records come in memcmp order, so each one usually belongs right
+    // before end() and is placed in constant time. Integer keys are compared
+    // in host byte order, which only matches for big-endian keys.
+    auto size = map_.size();
+    for (size_t i = 0; i < num; ++i)
+    {
+        auto record = make_record(keys[i], key_sz, values[i], value_sz);
+        if (map_.empty() || map_.rbegin()->first < record.first)
+            map_.emplace_hint(map_.end(), std::move(record));
+        else
+            map_.insert(std::move(record));
+    }
+    return map_.size() - size;
+}
 
-    Key k;
+template<typename Key, typename T>
+Key stlmap_wrapper<Key, T>::make_key(const char* key, size_t key_sz) const
+{
     if constexpr (std::is_arithmetic<Key>::value)
-        k = *reinterpret_cast<Key*>(const_cast<char*>(key));
+    {
+        Key k;
+        memcpy(&k, key, sizeof(Key));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (big_endian_keys_)
+        {
+            // Decode, so integers compare in the same order as the Bytes
+            if constexpr (sizeof(Key) == 8)
+                k = __builtin_bswap64(k);
+            else if constexpr (sizeof(Key) == 4)
+                k = __builtin_bswap32(k);
+        }
+#endif
+        return k;
+    }
     else
-        k = std::string(key, key_sz);
+        return std::string(key, key_sz);
+}
+
+template<typename Key, typename T>
+std::pair<Key,T> stlmap_wrapper<Key, T>::make_record(const char* key, size_t key_sz, const char* value, size_t value_sz) const
+{
+    Key k = make_key(key, key_sz);
 
     T v;
     if constexpr (std::is_arithmetic<T>::value)
@@ -88,8 +174,7 @@ bool stlmap_wrapper<Key, T>::insert(const char* key, size_t key_sz, const char*
     else
         v = std::string(value, value_sz);
 
-
-    return map_.insert(std::make_pair(k,v)).second;
+    return std::make_pair(k,v);
 }
 
 template<typename Key, typename T>
@@ -97,11 +182,7 @@ bool stlmap_wrapper<Key, T>::update(const char* key, size_t key_sz, const char*
 {
     std::unique_lock lock(mutex_);
 
-    typename std::map<Key,T>::iterator it;
-    if constexpr (std::is_arithmetic<Key>::value)
-        it = map_.find(*reinterpret_cast<Key*>(const_cast<char*>(key)));
-    else
-        it = map_.find(std::string(key, key_sz));
+    auto it = map_.find(make_key(key, key_sz));
 
     if (it == map_.end())
         return false;
@@ -121,10 +202,7 @@ bool stlmap_wrapper<Key,T>::remove(const char* key, size_t key_sz)
 {
     std::unique_lock lock(mutex_);
 
-    if constexpr (std::is_arithmetic<Key>::value)
-        return map_.erase(*reinterpret_cast<Key*>(const_cast<char*>(key))) == 1;
-    else
-        return map_.erase(std::string(key, key_sz)) == 1;
+    return map_.erase(make_key(key, key_sz)) == 1;
 }
 
 template<typename Key, typename T>
@@ -139,7 +217,7 @@ int stlmap_wrapper<Key,T>::scan(const char* key, size_t key_sz, int scan_sz, cha
     char* dst = reinterpret_cast<char*>(results.data());
     if constexpr (std::is_arithmetic<Key>::value)
     {
-        auto it = map_.lower_bound(*reinterpret_cast<Key*>(const_cast<char*>(key)));
+        auto it = map_.lower_bound(make_key(key, key_sz));
         if (it == map_.end())
             return 0;
 
@@ -162,7 +240,7 @@ int stlmap_wrapper<Key,T>::scan(const char* key, size_t key_sz, int scan_sz, cha
     }
     else
     {
-        auto it = map_.lower_bound(std::string(key, key_sz));
+        auto it = map_.lower_bound(make_key(key, key_sz));
         if (it == map_.end())
             return 0;
 